@@ -0,0 +1,316 @@
+//***************************************************************************************
+// bsdecr.cpp
+// Bit-sliced decryption of blocks of 64 (or 256 with AVX2) messages
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "bsdecr.h"
+#include "cpu.h"
+#include <string.h>
+
+#ifdef WB_HAS_AVX2
+#include <immintrin.h>
+#endif // WB_HAS_AVX2
+
+namespace NCrypt
+{
+
+enum
+{
+	in_planes = crpt_size * 8,
+	out_planes = msg_size * 8,
+	regs_num = in_planes + out_planes + 1 + (1 << CXorProgram::max_group)
+};
+
+//
+// Operations over planes of 64 bits
+//
+struct SWords64
+{
+	enum
+	{
+		lanes = 1
+	};
+
+	static void copy(uint64_t* d, const uint64_t* s)
+	{
+		d[0] = s[0];
+	}
+
+	static void xor_to(uint64_t* d, const uint64_t* s)
+	{
+		d[0] ^= s[0];
+	}
+
+	static void xor_of(uint64_t* d, const uint64_t* a, const uint64_t* b)
+	{
+		d[0] = a[0] ^ b[0];
+	}
+
+	static void and_to(uint64_t* d, const uint64_t* a, const uint64_t* b)
+	{
+		d[0] = a[0] & b[0];
+	}
+
+	static void set(uint64_t* d, uint64_t v)
+	{
+		d[0] = v;
+	}
+};
+
+#ifdef WB_HAS_AVX2
+
+//
+// Operations over planes of 256 bits
+//
+struct SWords256
+{
+	enum
+	{
+		lanes = 4
+	};
+
+	WB_TARGET("avx2") static void copy(uint64_t* d, const uint64_t* s)
+	{
+		_mm256_storeu_si256((__m256i*)d, _mm256_loadu_si256((const __m256i*)s));
+	}
+
+	WB_TARGET("avx2") static void xor_to(uint64_t* d, const uint64_t* s)
+	{
+		_mm256_storeu_si256((__m256i*)d, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)d), _mm256_loadu_si256((const __m256i*)s)));
+	}
+
+	WB_TARGET("avx2") static void xor_of(uint64_t* d, const uint64_t* a, const uint64_t* b)
+	{
+		_mm256_storeu_si256((__m256i*)d, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)a), _mm256_loadu_si256((const __m256i*)b)));
+	}
+
+	WB_TARGET("avx2") static void and_to(uint64_t* d, const uint64_t* a, const uint64_t* b)
+	{
+		_mm256_storeu_si256((__m256i*)d, _mm256_and_si256(_mm256_loadu_si256((const __m256i*)a), _mm256_loadu_si256((const __m256i*)b)));
+	}
+
+	WB_TARGET("avx2") static void set(uint64_t* d, uint64_t v)
+	{
+		_mm256_storeu_si256((__m256i*)d, _mm256_set1_epi64x((long long)v));
+	}
+};
+
+#endif // WB_HAS_AVX2
+
+//
+// Transpose of a matrix of 8x8 bits: bit j of byte i -> bit i of byte j
+//
+static uint64_t transpose8(uint64_t x)
+{
+	uint64_t t;
+
+	t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaull;
+	x ^= t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000cccc0000ccccull;
+	x ^= t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ull;
+	x ^= t ^ (t << 28);
+
+	return x;
+}
+
+// Only the first out_planes rows of the inverse second matrix are used (the rest are mix bits)
+CBitslicedDecryption::CBitslicedDecryption(const NCipher::CDecryption& d) : m_prog2(d.get_inv_bmtrx2(), out_planes),
+	m_prog1(d.get_inv_bmtrx1()), m_wide(false)
+{
+	// Combined inverse S-boxes are pairs of independent 4-bit S-boxes
+	for (int j = 0; j < nibbles_num; ++j)
+	{
+		uint8_t f[NCipher::CEncryption::sbst_size];
+		for (int x = 0; x < NCipher::CEncryption::sbst_size; ++x)
+		{
+			if (j & 1)
+				f[x] = d.get_inv_comb_substs()[j >> 1][x << 4] >> 4;
+			else
+				f[x] = d.get_inv_comb_substs()[j >> 1][x] & 0x0f;
+		}
+
+		for (int b = 0; b < 4; ++b)
+		{
+			// Moebius transform of the truth table of bit b
+			uint8_t a[NCipher::CEncryption::sbst_size];
+			for (int x = 0; x < NCipher::CEncryption::sbst_size; ++x)
+				a[x] = (f[x] >> b) & 1;
+
+			for (int i = 0; i < 4; ++i)
+			{
+				for (int x = 0; x < NCipher::CEncryption::sbst_size; ++x)
+				{
+					if (x & (1 << i))
+						a[x] ^= a[x ^ (1 << i)];
+				}
+			}
+
+			m_anf[j][b] = 0;
+			for (int x = 0; x < NCipher::CEncryption::sbst_size; ++x)
+				m_anf[j][b] |= (uint16_t)a[x] << x;
+		}
+	}
+
+	set_wide(true);
+}
+
+bool CBitslicedDecryption::is_wide() const
+{
+	return m_wide;
+}
+
+bool CBitslicedDecryption::set_wide(bool wide)
+{
+#ifdef WB_HAS_AVX2
+	if (wide && !NCpu::has_avx2())
+		return false;
+
+	m_wide = wide;
+
+	return true;
+#else
+	m_wide = false;
+
+	return !wide;
+#endif // WB_HAS_AVX2
+}
+
+template <typename W>
+void CBitslicedDecryption::decrypt_block(const uint8_t* crpts, size_t cnt, uint8_t* msgs) const
+{
+	// Both programs run over the same registers
+	uint64_t r[regs_num][W::lanes];
+	uint64_t m[NCipher::CEncryption::sbst_size][W::lanes];
+
+	uint64_t (*x)[W::lanes] = r + m_prog2.get_in_base();
+	uint64_t (*t)[W::lanes];
+
+	// Transpose: bit b of byte c of message k -> bit k of plane 8c + b, 8 messages at once
+	for (size_t g = 0; g < (size_t)W::lanes * 8; ++g)
+	{
+		for (int c = 0; c < crpt_size; ++c)
+		{
+			uint64_t v(0);
+			for (size_t i = 0; i < 8 && (g << 3) + i < cnt; ++i)
+				v |= (uint64_t)crpts[((g << 3) + i) * crpt_size + c] << (i << 3);
+
+			v = transpose8(v);
+
+			for (int b = 0; b < 8; ++b)
+				((uint8_t*)x[(c << 3) + b])[g] = (uint8_t)(v >> (b << 3));
+		}
+	}
+
+	// Multiply by inverse of the second matrix
+	m_prog2.run<W>(r[0]);
+	memmove(r + m_prog1.get_in_base(), r + m_prog2.get_out_base(), sizeof(uint64_t) * W::lanes * out_planes);
+
+	// Multiply by inverse of the first matrix
+	m_prog1.run<W>(r[0]);
+	x = r + m_prog1.get_out_base();
+	t = r + m_prog1.get_in_base();				// inputs are not needed any more
+
+	// Inverse S-boxes: monomial s is AND of input bits set in s, results go to t
+	for (int j = 0; j < nibbles_num; ++j)
+	{
+		uint64_t (*in)[W::lanes] = x + (j << 2);
+
+		W::set(m[0], ~(uint64_t)0);
+		for (int s = 1; s < NCipher::CEncryption::sbst_size; ++s)
+		{
+			int low = s & -s;
+			int bit = low == 1 ? 0 : low == 2 ? 1 : low == 4 ? 2 : 3;
+
+			if (s == low)
+				W::copy(m[s], in[bit]);
+			else
+				W::and_to(m[s], m[s ^ low], in[bit]);
+		}
+
+		for (int b = 0; b < 4; ++b)
+		{
+			uint64_t* out = t[(j << 2) + b];
+			W::set(out, 0);
+
+			for (int s = 0; s < NCipher::CEncryption::sbst_size; ++s)
+			{
+				if (m_anf[j][b] & (1 << s))
+					W::xor_to(out, m[s]);
+			}
+		}
+	}
+
+	// Transpose back
+	for (size_t g = 0; (g << 3) < cnt; ++g)
+	{
+		for (int r = 0; r < msg_size; ++r)
+		{
+			uint64_t v(0);
+			for (int b = 0; b < 8; ++b)
+				v |= (uint64_t)((const uint8_t*)t[(r << 3) + b])[g] << (b << 3);
+
+			v = transpose8(v);
+
+			for (size_t i = 0; i < 8 && (g << 3) + i < cnt; ++i)
+				msgs[((g << 3) + i) * msg_size + r] = (uint8_t)(v >> (i << 3));
+		}
+	}
+}
+
+#ifdef WB_HAS_AVX2
+
+WB_TARGET("avx2") WB_FLATTEN void CBitslicedDecryption::decrypt_wide_block(const uint8_t* crpts, size_t cnt, uint8_t* msgs) const
+{
+	decrypt_block<SWords256>(crpts, cnt, msgs);
+}
+
+#else
+
+void CBitslicedDecryption::decrypt_wide_block(const uint8_t* crpts, size_t cnt, uint8_t* msgs) const
+{
+	for (size_t pos = 0; pos < cnt; pos += block_size)
+		decrypt_block<SWords64>(crpts + pos * crpt_size, cnt - pos < block_size ? cnt - pos : block_size, msgs + pos * msg_size);
+}
+
+#endif // WB_HAS_AVX2
+
+void CBitslicedDecryption::decrypt_batch(const uint8_t* crpts, size_t n, uint8_t* msgs) const
+{
+	size_t pos(0);
+
+	if (m_wide)
+	{
+		for (; pos + block_size < n; pos += wide_block_size)
+		{
+			size_t cnt = n - pos < wide_block_size ? n - pos : wide_block_size;
+			decrypt_wide_block(crpts + pos * crpt_size, cnt, msgs + pos * msg_size);
+		}
+	}
+
+	for (; pos < n; pos += block_size)
+	{
+		size_t cnt = n - pos < block_size ? n - pos : block_size;
+		decrypt_block<SWords64>(crpts + pos * crpt_size, cnt, msgs + pos * msg_size);
+	}
+}
+
+}
@@ -0,0 +1,74 @@
+//***************************************************************************************
+// bsdecr.h
+// Bit-sliced decryption of blocks of 64 (or 256 with AVX2) messages
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "crypt.h"
+#include "xorprog.h"
+
+#ifndef BSDECR_H
+#define BSDECR_H
+
+namespace NCrypt
+{
+
+//
+// Bit b of all messages of a block is packed to one word (a plane), so inverse matrices are
+// applied as XOR programs over planes and inverse 4-bit S-boxes as Boolean circuits
+// (the algebraic normal form of every output bit). No lookups depend on messages
+//
+class CBitslicedDecryption
+{
+public:
+	enum
+	{
+		block_size = 64,							// Number of messages in a block of 64-bit planes
+		wide_block_size = 256,						// Number of messages in a block of 256-bit planes (AVX2)
+		nibbles_num = msg_size * 2
+	};
+
+public:
+	CBitslicedDecryption(const NCipher::CDecryption&);
+
+public:
+	// true if 256-bit planes are used (CPU supports AVX2)
+	bool is_wide() const;
+	// Returns false if CPU does not support AVX2
+	bool set_wide(bool);
+
+	// crpt_size bytes -> msg_size bytes
+	void decrypt_batch(const uint8_t*, size_t, uint8_t*) const;
+
+private:
+	template <typename W>
+	void decrypt_block(const uint8_t*, size_t, uint8_t*) const;
+	void decrypt_wide_block(const uint8_t*, size_t, uint8_t*) const;
+
+private:
+	CXorProgram				m_prog2;						// Inverse second matrix (without mix rows)
+	CXorProgram				m_prog1;						// Inverse first matrix
+	uint16_t				m_anf[nibbles_num][4];			// Bit s of m_anf[j][b] is set if monomial s is in ANF of bit b of S-box j
+	bool					m_wide;
+};
+
+}
+
+#endif // BSDECR_H
@@ -0,0 +1,394 @@
+//***************************************************************************************
+// chacha.cpp
+// ChaCha20-Poly1305 AEAD (RFC 8439)
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "chacha.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHACHA_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace NChaCha
+{
+
+static uint32_t load32(const uint8_t* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void store32(uint8_t* p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static void store64(uint8_t* p, uint64_t v)
+{
+	store32(p, (uint32_t)v);
+	store32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint32_t rotl32(uint32_t v, int n)
+{
+	return (v << n) | (v >> (32 - n));
+}
+
+#define CHACHA_QR(a, b, c, d) \
+	a += b; d ^= a; d = rotl32(d, 16); \
+	c += d; b ^= c; b = rotl32(b, 12); \
+	a += b; d ^= a; d = rotl32(d, 8); \
+	c += d; b ^= c; b = rotl32(b, 7);
+
+static void init_state(uint32_t* s, const uint8_t* key, const uint8_t* nonce, uint32_t counter)
+{
+	s[0] = 0x61707865;
+	s[1] = 0x3320646e;
+	s[2] = 0x79622d32;
+	s[3] = 0x6b206574;
+
+	for (int i = 0; i < 8; ++i)
+		s[4 + i] = load32(key + (i << 2));
+
+	s[12] = counter;
+	s[13] = load32(nonce);
+	s[14] = load32(nonce + 4);
+	s[15] = load32(nonce + 8);
+}
+
+static void chacha20_block(const uint32_t* s, uint8_t* out)
+{
+	uint32_t x[16];
+	memcpy(x, s, sizeof(x));
+
+	for (int i = 0; i < 10; ++i)
+	{
+		CHACHA_QR(x[0], x[4], x[8], x[12]);
+		CHACHA_QR(x[1], x[5], x[9], x[13]);
+		CHACHA_QR(x[2], x[6], x[10], x[14]);
+		CHACHA_QR(x[3], x[7], x[11], x[15]);
+		CHACHA_QR(x[0], x[5], x[10], x[15]);
+		CHACHA_QR(x[1], x[6], x[11], x[12]);
+		CHACHA_QR(x[2], x[7], x[8], x[13]);
+		CHACHA_QR(x[3], x[4], x[9], x[14]);
+	}
+
+	for (int i = 0; i < 16; ++i)
+		store32(out + (i << 2), x[i] + s[i]);
+}
+
+#ifdef CHACHA_SSE2
+
+static __m128i rotl_sse2(__m128i v, int n)
+{
+	return _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - n));
+}
+
+static __m128i rotl16_sse2(__m128i v)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+}
+
+#define CHACHA_QR_SSE2(a, b, c, d) \
+	a = _mm_add_epi32(a, b); d = rotl16_sse2(_mm_xor_si128(d, a)); \
+	c = _mm_add_epi32(c, d); b = rotl_sse2(_mm_xor_si128(b, c), 12); \
+	a = _mm_add_epi32(a, b); d = rotl_sse2(_mm_xor_si128(d, a), 8); \
+	c = _mm_add_epi32(c, d); b = rotl_sse2(_mm_xor_si128(b, c), 7);
+
+//
+// Four consecutive blocks, every vector holds the same word of four blocks
+//
+static void chacha20_xor4_sse2(const uint32_t* s, const uint8_t* in, uint8_t* out)
+{
+	__m128i x[16], o[16];
+	for (int i = 0; i < 16; ++i)
+		x[i] = o[i] = _mm_set1_epi32((int)s[i]);
+
+	x[12] = o[12] = _mm_add_epi32(x[12], _mm_set_epi32(3, 2, 1, 0));
+
+	for (int i = 0; i < 10; ++i)
+	{
+		CHACHA_QR_SSE2(x[0], x[4], x[8], x[12]);
+		CHACHA_QR_SSE2(x[1], x[5], x[9], x[13]);
+		CHACHA_QR_SSE2(x[2], x[6], x[10], x[14]);
+		CHACHA_QR_SSE2(x[3], x[7], x[11], x[15]);
+		CHACHA_QR_SSE2(x[0], x[5], x[10], x[15]);
+		CHACHA_QR_SSE2(x[1], x[6], x[11], x[12]);
+		CHACHA_QR_SSE2(x[2], x[7], x[8], x[13]);
+		CHACHA_QR_SSE2(x[3], x[4], x[9], x[14]);
+	}
+
+	for (int i = 0; i < 16; ++i)
+		x[i] = _mm_add_epi32(x[i], o[i]);
+
+	// Transpose every group of four words back to the block order
+	for (int g = 0; g < 4; ++g)
+	{
+		__m128i t0 = _mm_unpacklo_epi32(x[4 * g], x[4 * g + 1]);
+		__m128i t1 = _mm_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+		__m128i t2 = _mm_unpackhi_epi32(x[4 * g], x[4 * g + 1]);
+		__m128i t3 = _mm_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+
+		__m128i b[4];
+		b[0] = _mm_unpacklo_epi64(t0, t1);
+		b[1] = _mm_unpackhi_epi64(t0, t1);
+		b[2] = _mm_unpacklo_epi64(t2, t3);
+		b[3] = _mm_unpackhi_epi64(t2, t3);
+
+		for (int j = 0; j < 4; ++j)
+		{
+			size_t off = j * block_size + g * 16;
+			__m128i v = _mm_loadu_si128((const __m128i*)(in + off));
+			_mm_storeu_si128((__m128i*)(out + off), _mm_xor_si128(v, b[j]));
+		}
+	}
+}
+
+#endif // CHACHA_SSE2
+
+void chacha20_xor(const uint8_t* key, const uint8_t* nonce, uint32_t counter, const uint8_t* in, size_t len, uint8_t* out)
+{
+	uint32_t s[16];
+	init_state(s, key, nonce, counter);
+
+#ifdef CHACHA_SSE2
+	for (; len >= 4 * block_size; len -= 4 * block_size)
+	{
+		chacha20_xor4_sse2(s, in, out);
+		s[12] += 4;
+		in += 4 * block_size;
+		out += 4 * block_size;
+	}
+#endif // CHACHA_SSE2
+
+	uint8_t ks[block_size];
+	while (len)
+	{
+		chacha20_block(s, ks);
+		++s[12];
+
+		size_t n = len < block_size ? len : block_size;
+		for (size_t i = 0; i < n; ++i)
+			out[i] = in[i] ^ ks[i];
+
+		in += n;
+		out += n;
+		len -= n;
+	}
+
+	memset(ks, 0, sizeof(ks));
+}
+
+CPoly1305::CPoly1305(const uint8_t* key) : m_buf_len(0)
+{
+	// r is clamped
+	m_r[0] = (load32(key)) & 0x3ffffff;
+	m_r[1] = (load32(key + 3) >> 2) & 0x3ffff03;
+	m_r[2] = (load32(key + 6) >> 4) & 0x3ffc0ff;
+	m_r[3] = (load32(key + 9) >> 6) & 0x3f03fff;
+	m_r[4] = (load32(key + 12) >> 8) & 0x00fffff;
+
+	for (int i = 0; i < 5; ++i)
+		m_h[i] = 0;
+
+	for (int i = 0; i < 4; ++i)
+		m_pad[i] = load32(key + 16 + (i << 2));
+}
+
+CPoly1305::~CPoly1305()
+{
+	memset(m_r, 0, sizeof(m_r));
+	memset(m_pad, 0, sizeof(m_pad));
+}
+
+//
+// h = (h + m) * r mod 2^130 - 5 for every 16-byte block, limbs are 26 bits
+//
+void CPoly1305::blocks(const uint8_t* m, size_t len, uint32_t hibit)
+{
+	const uint32_t mask = 0x3ffffff;
+
+	uint32_t r0 = m_r[0], r1 = m_r[1], r2 = m_r[2], r3 = m_r[3], r4 = m_r[4];
+	uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+	uint32_t h0 = m_h[0], h1 = m_h[1], h2 = m_h[2], h3 = m_h[3], h4 = m_h[4];
+
+	for (; len >= 16; len -= 16, m += 16)
+	{
+		h0 += (load32(m)) & mask;
+		h1 += (load32(m + 3) >> 2) & mask;
+		h2 += (load32(m + 6) >> 4) & mask;
+		h3 += (load32(m + 9) >> 6) & mask;
+		h4 += (load32(m + 12) >> 8) | hibit;
+
+		uint64_t d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 + (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+		uint64_t d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 + (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+		uint64_t d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 + (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+		uint64_t d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 + (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+		uint64_t d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 + (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+
+		uint32_t c = (uint32_t)(d0 >> 26); h0 = (uint32_t)d0 & mask;
+		d1 += c; c = (uint32_t)(d1 >> 26); h1 = (uint32_t)d1 & mask;
+		d2 += c; c = (uint32_t)(d2 >> 26); h2 = (uint32_t)d2 & mask;
+		d3 += c; c = (uint32_t)(d3 >> 26); h3 = (uint32_t)d3 & mask;
+		d4 += c; c = (uint32_t)(d4 >> 26); h4 = (uint32_t)d4 & mask;
+		h0 += c * 5; c = h0 >> 26; h0 &= mask;
+		h1 += c;
+	}
+
+	m_h[0] = h0; m_h[1] = h1; m_h[2] = h2; m_h[3] = h3; m_h[4] = h4;
+}
+
+void CPoly1305::update(const uint8_t* m, size_t len)
+{
+	if (m_buf_len)
+	{
+		size_t n = 16 - m_buf_len;
+		if (n > len)
+			n = len;
+
+		memcpy(m_buf + m_buf_len, m, n);
+		m_buf_len += n;
+		m += n;
+		len -= n;
+
+		if (m_buf_len < 16)
+			return;
+
+		blocks(m_buf, 16, 1 << 24);
+		m_buf_len = 0;
+	}
+
+	size_t n = len & ~(size_t)15;
+	blocks(m, n, 1 << 24);
+
+	m_buf_len = len - n;
+	memcpy(m_buf, m + n, m_buf_len);
+}
+
+void CPoly1305::final(uint8_t* tag)
+{
+	const uint32_t mask = 0x3ffffff;
+
+	if (m_buf_len)
+	{
+		m_buf[m_buf_len] = 1;
+		for (size_t i = m_buf_len + 1; i < 16; ++i)
+			m_buf[i] = 0;
+
+		blocks(m_buf, 16, 0);
+	}
+
+	uint32_t h0 = m_h[0], h1 = m_h[1], h2 = m_h[2], h3 = m_h[3], h4 = m_h[4];
+
+	uint32_t c = h1 >> 26; h1 &= mask;
+	h2 += c; c = h2 >> 26; h2 &= mask;
+	h3 += c; c = h3 >> 26; h3 &= mask;
+	h4 += c; c = h4 >> 26; h4 &= mask;
+	h0 += c * 5; c = h0 >> 26; h0 &= mask;
+	h1 += c;
+
+	// g = h + 5 - 2^130, take g if it is not negative
+	uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= mask;
+	uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= mask;
+	uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= mask;
+	uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= mask;
+	uint32_t g4 = h4 + c - (1 << 26);
+
+	uint32_t sel = (g4 >> 31) - 1;
+	h0 = (h0 & ~sel) | (g0 & sel);
+	h1 = (h1 & ~sel) | (g1 & sel);
+	h2 = (h2 & ~sel) | (g2 & sel);
+	h3 = (h3 & ~sel) | (g3 & sel);
+	h4 = (h4 & ~sel) | (g4 & sel);
+
+	// tag = (h + pad) mod 2^128
+	uint32_t w0 = h0 | (h1 << 26);
+	uint32_t w1 = (h1 >> 6) | (h2 << 20);
+	uint32_t w2 = (h2 >> 12) | (h3 << 14);
+	uint32_t w3 = (h3 >> 18) | (h4 << 8);
+
+	uint64_t f = (uint64_t)w0 + m_pad[0];
+	store32(tag, (uint32_t)f);
+	f = (uint64_t)w1 + m_pad[1] + (f >> 32);
+	store32(tag + 4, (uint32_t)f);
+	f = (uint64_t)w2 + m_pad[2] + (f >> 32);
+	store32(tag + 8, (uint32_t)f);
+	f = (uint64_t)w3 + m_pad[3] + (f >> 32);
+	store32(tag + 12, (uint32_t)f);
+}
+
+static void aead_tag(const uint8_t* key, const uint8_t* nonce, const uint8_t* aad, size_t aad_len,
+	const uint8_t* crpt, size_t len, uint8_t* tag)
+{
+	static const uint8_t zeros[16] = { 0 };
+
+	// One-time Poly1305 key is the first half of the block with counter 0
+	uint8_t otk[block_size];
+	memset(otk, 0, sizeof(otk));
+	chacha20_xor(key, nonce, 0, otk, sizeof(otk), otk);
+
+	CPoly1305 p(otk);
+	memset(otk, 0, sizeof(otk));
+
+	p.update(aad, aad_len);
+	p.update(zeros, (16 - aad_len % 16) % 16);
+	p.update(crpt, len);
+	p.update(zeros, (16 - len % 16) % 16);
+
+	uint8_t lens[16];
+	store64(lens, aad_len);
+	store64(lens + 8, len);
+	p.update(lens, sizeof(lens));
+
+	p.final(tag);
+}
+
+void aead_encrypt(const uint8_t* key, const uint8_t* nonce, const uint8_t* aad, size_t aad_len,
+	const uint8_t* in, size_t len, uint8_t* out, uint8_t* tag)
+{
+	chacha20_xor(key, nonce, 1, in, len, out);
+	aead_tag(key, nonce, aad, aad_len, out, len, tag);
+}
+
+bool aead_decrypt(const uint8_t* key, const uint8_t* nonce, const uint8_t* aad, size_t aad_len,
+	const uint8_t* in, size_t len, uint8_t* out, const uint8_t* tag)
+{
+	uint8_t t[tag_size];
+	aead_tag(key, nonce, aad, aad_len, in, len, t);
+
+	// Constant time comparison
+	uint8_t diff(0);
+	for (int i = 0; i < tag_size; ++i)
+		diff |= t[i] ^ tag[i];
+
+	if (diff)
+		return false;
+
+	chacha20_xor(key, nonce, 1, in, len, out);
+
+	return true;
+}
+
+}
@@ -0,0 +1,75 @@
+//***************************************************************************************
+// chacha.h
+// ChaCha20-Poly1305 AEAD (RFC 8439)
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef CHACHA_H
+#define CHACHA_H
+
+namespace NChaCha
+{
+
+enum
+{
+	key_size = 32,
+	nonce_size = 12,
+	block_size = 64,
+	tag_size = 16
+};
+
+// out = in ^ ChaCha20 key stream starting from the block counter
+// Four blocks are processed at once when SSE2 is available
+void chacha20_xor(const uint8_t* key, const uint8_t* nonce, uint32_t counter, const uint8_t* in, size_t len, uint8_t* out);
+
+class CPoly1305
+{
+public:
+	CPoly1305(const uint8_t*);				// 32-byte one-time key
+	~CPoly1305();
+
+public:
+	void update(const uint8_t*, size_t);
+	void final(uint8_t*);					// tag_size bytes
+
+private:
+	void blocks(const uint8_t*, size_t, uint32_t);
+
+private:
+	uint32_t	m_r[5];
+	uint32_t	m_h[5];
+	uint32_t	m_pad[4];
+	uint8_t		m_buf[16];
+	size_t		m_buf_len;
+};
+
+void aead_encrypt(const uint8_t* key, const uint8_t* nonce, const uint8_t* aad, size_t aad_len,
+	const uint8_t* in, size_t len, uint8_t* out, uint8_t* tag);
+
+// Returns false (and does not decrypt) if the tag is wrong
+bool aead_decrypt(const uint8_t* key, const uint8_t* nonce, const uint8_t* aad, size_t aad_len,
+	const uint8_t* in, size_t len, uint8_t* out, const uint8_t* tag);
+
+}
+
+#endif // CHACHA_H
@@ -22,6 +22,8 @@
 //***************************************************************************************
 
 #include "cipher.h"
+#include <string.h>
+#include <stdexcept>
 
 namespace NCipher
 {
@@ -109,6 +111,39 @@ void unit_sbox(uint8_t* sbx, uint32_t size)
 		sbx[i] = (uint8_t)i;
 }
 
+static uint16_t get_check_mix(const CEncryption::tbox& row)
+{
+	return row[CEncryption::tbox_size - 2] | (row[CEncryption::tbox_size - 1] << 8);
+}
+
+void gen_check_tbxs(CDecryption::check_arrays& res, const CDecryption::mixed_comb_tbox_arrays& tbxs2)
+{
+	for (int i = 0; i < CEncryption::tbox_size; ++i)
+		for (int j = 0; j < CEncryption::comb_sbst_size; ++j)
+			res[i][j] = get_check_mix(tbxs2[i][j]);
+}
+
+uint8_t gen_mixes(CEncryption::mix_arrays& res, const CEncryption::comb_tbox_arrays& tbxs, const CDecryption::check_arrays& check)
+{
+	// Mix bytes of a public row after the inverse second matrix are the mixes of its table
+	uint8_t high_mix(0);
+	for (int k = 0; k < CEncryption::comb_sbsts_num; ++k)
+	{
+		for (int j = 0; j < CEncryption::comb_sbst_size; ++j)
+		{
+			uint16_t mix(0);
+			for (int i = 0; i < CEncryption::tbox_size; ++i)
+				mix ^= check[i][tbxs[k][j][i]];
+
+			res[k][j] = (uint8_t)mix;
+			if (!j)
+				high_mix ^= (uint8_t)(mix >> 8);
+		}
+	}
+
+	return high_mix;
+}
+
 void combine_tboxes(CEncryption::tbox& res, const CEncryption::tbox& t1, const CEncryption::tbox& t2)
 {
 	for (int i = 0; i < CEncryption::tbox_size; ++i)
@@ -128,6 +163,8 @@ CEncryption::CEncryption(const CEncryption &e) : m_bmtrx1(e.m_bmtrx1), m_bmtrx2(
 	memcpy_s(m_substs, sizeof(subst_arrays), e.m_substs, sizeof(subst_arrays));
 	memcpy_s(m_tbxs, sizeof(tbox_arrays), e.m_tbxs, sizeof(tbox_arrays));
 	memcpy_s(m_comb_tbxs, sizeof(comb_tbox_arrays), e.m_comb_tbxs, sizeof(comb_tbox_arrays));
+	memcpy_s(m_mixes, sizeof(mix_arrays), e.m_mixes, sizeof(mix_arrays));
+	memcpy_s(m_high_mixes, sizeof(high_mix_array), e.m_high_mixes, sizeof(high_mix_array));
 }
 
 const CEncryption& CEncryption::operator=(const CEncryption& e)
@@ -139,6 +176,8 @@ const CEncryption& CEncryption::operator=(const CEncryption& e)
 	memcpy_s(m_substs, sizeof(subst_arrays), e.m_substs, sizeof(subst_arrays));
 	memcpy_s(m_tbxs, sizeof(tbox_arrays), e.m_tbxs, sizeof(tbox_arrays));
 	memcpy_s(m_comb_tbxs, sizeof(comb_tbox_arrays), e.m_comb_tbxs, sizeof(comb_tbox_arrays));
+	memcpy_s(m_mixes, sizeof(mix_arrays), e.m_mixes, sizeof(mix_arrays));
+	memcpy_s(m_high_mixes, sizeof(high_mix_array), e.m_high_mixes, sizeof(high_mix_array));
 
 	return *this;
 }
@@ -172,6 +211,16 @@ const CEncryption::comb_tbox_arrays& CEncryption::get_comb_tbxs() const
 	return m_comb_tbxs;
 }
 
+const CEncryption::mix_arrays& CEncryption::get_mixes() const
+{
+	return m_mixes;
+}
+
+const CEncryption::high_mix_array& CEncryption::get_high_mixes() const
+{
+	return m_high_mixes;
+}
+
 void CEncryption::gen_sbox(uint8_t* sa, uint32_t sa_size)
 {
 	mpf_t x, p, left, right, s1, delta, imm;
@@ -207,7 +256,7 @@ void CEncryption::gen_sbox(uint8_t* sa, uint32_t sa_size)
 
 		uint8_t index = (uint8_t)mpf_get_d(mf_index);
 
-		if (index < 0 || index > sa_size)
+		if (index < 0 || index >= sa_size)
 			continue;
 		if (is_init[index])
 			continue;
@@ -284,8 +333,9 @@ void CEncryption::comb_tboxes()
 		tbox_array &tba1(m_tbxs[i]);
 		tbox_array &tba2(m_tbxs[i + 1]);
 
-		uint8_t mixes[comb_sbst_size];
+		mix_array &mixes(m_mixes[i / 2]);
 		gen_sbox(mixes, comb_sbst_size);
+		m_high_mixes[i / 2] = high_mixes[i / 2];
 
 		for (int v = 0; v < sbst_size; ++v)
 		{
@@ -321,7 +371,7 @@ void CEncryption::gen_key()
 }
 
 
-CDecryption::CDecryption(const CEncryption& e) : m_init(false), m_e(e)
+CDecryption::CDecryption(const CEncryption& e) : m_e(e), m_init(false), m_geometry(byte_geometry), m_high_mix(0)
 {
 }
 
@@ -329,18 +379,23 @@ CDecryption::~CDecryption()
 {
 }
 
-CDecryption::CDecryption(const CDecryption& d) : m_init(d.m_init), m_e(d.m_e), m_inv_bmtrx1(d.m_inv_bmtrx1), m_inv_bmtrx2(d.m_inv_bmtrx2)
+CDecryption::CDecryption(const CDecryption& d) : m_e(d.m_e), m_init(d.m_init), m_geometry(d.m_geometry), m_inv_bmtrx1(d.m_inv_bmtrx1), m_inv_bmtrx2(d.m_inv_bmtrx2), m_high_mix(d.m_high_mix)
 {
 	memcpy_s(m_inv_comb_tbxs1, sizeof(clear_comb_tbox_arrays), d.m_inv_comb_tbxs1, sizeof(clear_comb_tbox_arrays));
 	memcpy_s(m_inv_comb_tbxs2, sizeof(mixed_comb_tbox_arrays), d.m_inv_comb_tbxs2, sizeof(mixed_comb_tbox_arrays));
 	memcpy_s(m_inv_comb_substs, sizeof(subst_arrays), d.m_inv_comb_substs, sizeof(subst_arrays));
 	memcpy_s(m_final_tbxs, sizeof(clear_comb_tbox_arrays), d.m_final_tbxs, sizeof(clear_comb_tbox_arrays));
+	memcpy_s(m_inv_nibble_tbxs2, sizeof(mixed_nibble_tbox_arrays), d.m_inv_nibble_tbxs2, sizeof(mixed_nibble_tbox_arrays));
+	memcpy_s(m_inv_nibble_tbxs1, sizeof(clear_nibble_tbox_arrays), d.m_inv_nibble_tbxs1, sizeof(clear_nibble_tbox_arrays));
+	memcpy_s(m_check_tbxs, sizeof(check_arrays), d.m_check_tbxs, sizeof(check_arrays));
 }
 
 const CDecryption& CDecryption::operator=(const CDecryption& d)
 {
 	m_init = d.m_init;
+	m_geometry = d.m_geometry;
 	m_e = d.m_e;
+	m_high_mix = d.m_high_mix;
 
 	m_inv_bmtrx1 = d.m_inv_bmtrx1;
 	m_inv_bmtrx2 = d.m_inv_bmtrx2;
@@ -349,6 +404,9 @@ const CDecryption& CDecryption::operator=(const CDecryption& d)
 	memcpy_s(m_inv_comb_tbxs2, sizeof(mixed_comb_tbox_arrays), d.m_inv_comb_tbxs2, sizeof(mixed_comb_tbox_arrays));
 	memcpy_s(m_inv_comb_substs, sizeof(subst_arrays), d.m_inv_comb_substs, sizeof(subst_arrays));
 	memcpy_s(m_final_tbxs, sizeof(clear_comb_tbox_arrays), d.m_final_tbxs, sizeof(clear_comb_tbox_arrays));
+	memcpy_s(m_inv_nibble_tbxs2, sizeof(mixed_nibble_tbox_arrays), d.m_inv_nibble_tbxs2, sizeof(mixed_nibble_tbox_arrays));
+	memcpy_s(m_inv_nibble_tbxs1, sizeof(clear_nibble_tbox_arrays), d.m_inv_nibble_tbxs1, sizeof(clear_nibble_tbox_arrays));
+	memcpy_s(m_check_tbxs, sizeof(check_arrays), d.m_check_tbxs, sizeof(check_arrays));
 
 	return *this;
 }
@@ -368,30 +426,151 @@ bool CDecryption::is_init() const
 	return m_init;
 }
 
+CDecryption::geometry CDecryption::get_geometry() const
+{
+	return m_geometry;
+}
+
+const CDecryption::subst_arrays& CDecryption::get_inv_comb_substs() const
+{
+	return m_inv_comb_substs;
+}
+
+const NBMatrix::TBMatrix<CEncryption::bit_size1, CEncryption::bit_size1>& CDecryption::get_inv_bmtrx1() const
+{
+	return m_inv_bmtrx1;
+}
+
+const NBMatrix::TBMatrix<CEncryption::bit_size2, CEncryption::bit_size2>& CDecryption::get_inv_bmtrx2() const
+{
+	return m_inv_bmtrx2;
+}
+
+// Tables of the other geometry are not generated
+void CDecryption::check_geometry(geometry g) const
+{
+	if (m_geometry != g)
+		throw std::runtime_error("ERROR: Tables of another geometry!!!\n");
+}
+
 const CDecryption::mixed_comb_tbox_arrays& CDecryption::get_inv_comb_tbxs2() const
 {
+	check_geometry(byte_geometry);
 	return m_inv_comb_tbxs2;
 }
 const CDecryption::clear_comb_tbox_arrays& CDecryption::get_inv_comb_tbxs1() const
 {
+	check_geometry(byte_geometry);
 	return m_inv_comb_tbxs1;
 }
 const CDecryption::clear_comb_tbox_arrays& CDecryption::get_final_tbxs() const
 {
+	check_geometry(byte_geometry);
 	return m_final_tbxs;
 }
 
-bool CDecryption::init()
+const CDecryption::mixed_nibble_tbox_arrays& CDecryption::get_inv_nibble_tbxs2() const
+{
+	check_geometry(nibble_geometry);
+	return m_inv_nibble_tbxs2;
+}
+
+const CDecryption::clear_nibble_tbox_arrays& CDecryption::get_inv_nibble_tbxs1() const
 {
+	check_geometry(nibble_geometry);
+	return m_inv_nibble_tbxs1;
+}
+
+bool CDecryption::init(geometry g)
+{
+	m_geometry = g;
+
 	gen_inv_matricies();
 	gen_inv_sbox();
-	gen_inv_tbxs2(); 
-	gen_inv_tbxs1(); 
-	gen_final_tboxes();
+
+	if (g == nibble_geometry)
+	{
+		gen_inv_nibble_tbxs2();
+		gen_inv_nibble_tbxs1();
+	}
+	else
+	{
+		gen_inv_tbxs2();
+		gen_inv_tbxs1();
+		gen_final_tboxes();
+	}
+
+	gen_check_tbxs();
 	
 	return (m_init = true);
 }
 
+void CDecryption::decrypt(const uint8_t* crpt, uint8_t* msg) const
+{
+	uint8_t t0[CEncryption::tbox_size];
+	uint8_t t1[CEncryption::tbox_clear_size];
+
+	memset(t0, 0, sizeof(t0));
+	memset(t1, 0, sizeof(t1));
+
+	if (m_geometry == nibble_geometry)
+	{
+		for (int i = 0; i < CEncryption::tbox_size; ++i)
+		{
+			const uint8_t *lo = m_inv_nibble_tbxs2[i << 1][crpt[i] & 0x0f];
+			const uint8_t *hi = m_inv_nibble_tbxs2[(i << 1) + 1][crpt[i] >> CEncryption::sbx_elem_size];
+
+			for (int j = 0; j < CEncryption::tbox_size; ++j)
+				t0[j] ^= lo[j] ^ hi[j];
+		}
+
+		for (int i = 0; i < CEncryption::tbox_clear_size; ++i)
+		{
+			const uint8_t *lo = m_inv_nibble_tbxs1[i << 1][t0[i] & 0x0f];
+			const uint8_t *hi = m_inv_nibble_tbxs1[(i << 1) + 1][t0[i] >> CEncryption::sbx_elem_size];
+
+			for (int j = 0; j < CEncryption::tbox_clear_size; ++j)
+				t1[j] ^= lo[j] ^ hi[j];
+		}
+	}
+	else
+	{
+		for (int i = 0; i < CEncryption::tbox_size; ++i)
+		{
+			for (int j = 0; j < CEncryption::tbox_size; ++j)
+				t0[j] ^= m_inv_comb_tbxs2[i][crpt[i]][j];
+		}
+
+		for (int i = 0; i < CEncryption::tbox_clear_size; ++i)
+		{
+			for (int j = 0; j < CEncryption::tbox_clear_size; ++j)
+				t1[j] ^= m_inv_comb_tbxs1[i][t0[i]][j];
+		}
+	}
+
+	// Inverse substitution (final T-boxes only place its result to byte i)
+	for (int i = 0; i < CEncryption::comb_sbsts_num; ++i)
+		msg[i] = m_inv_comb_substs[i][t1[i]];
+}
+
+bool CDecryption::decrypt_checked(const uint8_t* crpt, uint8_t* msg) const
+{
+	uint16_t mix(0);
+	for (int i = 0; i < CEncryption::tbox_size; ++i)
+		mix ^= m_check_tbxs[i][crpt[i]];
+
+	if ((uint8_t)(mix >> 8) != m_high_mix)
+		return false;
+
+	decrypt(crpt, msg);
+
+	uint8_t low_mix(0);
+	for (int i = 0; i < CEncryption::comb_sbsts_num; ++i)
+		low_mix ^= m_e.get_mixes()[i][msg[i]];
+
+	return low_mix == (uint8_t)mix;
+}
+
 void CDecryption::gen_inv_matricies()
 {
 	NBMatrix::inverse(m_e.get_bmtrx1(), m_inv_bmtrx1);
@@ -464,11 +643,56 @@ void CDecryption::gen_inv_tbxs1()
 	{
 		for (int j = 0; j < CEncryption::comb_sbst_size; ++j)
 		{
-			gen_tbox_elem<NBMatrix::TBMatrix<CEncryption::bit_size1, CEncryption::bit_size1> >(&m_inv_comb_tbxs1[i][j][0], CEncryption::tbox_size, j, i);
+			gen_tbox_elem<NBMatrix::TBMatrix<CEncryption::bit_size1, CEncryption::bit_size1> >(&m_inv_comb_tbxs1[i][j][0], CEncryption::tbox_clear_size, j, i);
+		}
+	}
+}
+
+// Rows for a low nibble u are rows of byte u, rows for a high nibble v are rows of byte v << 4
+void CDecryption::gen_inv_nibble_tbxs2()
+{
+	for (int i = 0; i < CEncryption::tbox_size; ++i)
+	{
+		for (int j = 0; j < CEncryption::sbst_size; ++j)
+		{
+			gen_tbox_elem<NBMatrix::TBMatrix<CEncryption::bit_size2, CEncryption::bit_size2> >(&m_inv_nibble_tbxs2[i << 1][j][0], CEncryption::tbox_size, j, i);
+			gen_tbox_elem<NBMatrix::TBMatrix<CEncryption::bit_size2, CEncryption::bit_size2> >(&m_inv_nibble_tbxs2[(i << 1) + 1][j][0], CEncryption::tbox_size, j << CEncryption::sbx_elem_size, i);
+		}
+	}
+}
+
+void CDecryption::gen_inv_nibble_tbxs1()
+{
+	for (int i = 0; i < CEncryption::tbox_clear_size; ++i)
+	{
+		for (int j = 0; j < CEncryption::sbst_size; ++j)
+		{
+			gen_tbox_elem<NBMatrix::TBMatrix<CEncryption::bit_size1, CEncryption::bit_size1> >(&m_inv_nibble_tbxs1[i << 1][j][0], CEncryption::tbox_clear_size, j, i);
+			gen_tbox_elem<NBMatrix::TBMatrix<CEncryption::bit_size1, CEncryption::bit_size1> >(&m_inv_nibble_tbxs1[(i << 1) + 1][j][0], CEncryption::tbox_clear_size, j << CEncryption::sbx_elem_size, i);
 		}
 	}
 }
 
+void CDecryption::gen_check_tbxs()
+{
+	if (m_geometry == nibble_geometry)
+	{
+		// Mix bytes of a combined row are the XOR of mix bytes of its nibble rows
+		for (int i = 0; i < CEncryption::tbox_size; ++i)
+			for (int j = 0; j < CEncryption::comb_sbst_size; ++j)
+				m_check_tbxs[i][j] = get_check_mix(m_inv_nibble_tbxs2[i << 1][j & 0x0f]) ^
+					get_check_mix(m_inv_nibble_tbxs2[(i << 1) + 1][j >> CEncryption::sbx_elem_size]);
+	}
+	else
+	{
+		NCipher::gen_check_tbxs(m_check_tbxs, m_inv_comb_tbxs2);
+	}
+
+	m_high_mix = 0;
+	for (int i = 0; i < CEncryption::comb_sbsts_num; ++i)
+		m_high_mix ^= m_e.get_high_mixes()[i];
+}
+
 void CDecryption::gen_final_tboxes()
 {
 	for (int i = 0; i < CEncryption::tbox_clear_size; ++i)
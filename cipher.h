@@ -62,6 +62,10 @@ public:
 	typedef tbox			comb_tbox_array[comb_sbst_size];
 	typedef comb_tbox_array	comb_tbox_arrays[comb_sbsts_num];
 
+	typedef uint8_t			mix_array[comb_sbst_size];
+	typedef mix_array		mix_arrays[comb_sbsts_num];
+	typedef uint8_t			high_mix_array[comb_sbsts_num];
+
 	enum
 	{
 		tbls_size = sizeof(comb_tbox_arrays)
@@ -85,6 +89,8 @@ public:
 	const subst_arrays&								get_substs() const;
 	const tbox_arrays&								get_tbxs() const;
 	const comb_tbox_arrays&							get_comb_tbxs() const;
+	const mix_arrays&								get_mixes() const;
+	const high_mix_array&							get_high_mixes() const;
 
 private:
 	void gen_sbox(uint8_t*, uint32_t);
@@ -102,6 +108,8 @@ private:
 	NBMatrix::TBMatrix<bit_size2, bit_size2>		m_bmtrx2;
 	tbox_arrays										m_tbxs;
 	comb_tbox_arrays								m_comb_tbxs;
+	mix_arrays										m_mixes;			// low 8 mix bits of combined T-boxes
+	high_mix_array									m_high_mixes;		// high 8 mix bits of combined T-boxes
 	bool											m_init;
 };
 
@@ -118,12 +126,27 @@ public:
 	
 	typedef CEncryption::comb_tbox_array	mixed_comb_tbox_arrays[CEncryption::tbox_size];
 
+	typedef clear_tbox						clear_nibble_tbox_array[CEncryption::sbst_size];
+	typedef clear_nibble_tbox_array			clear_nibble_tbox_arrays[CEncryption::sbsts_num];
+	typedef CEncryption::tbox_array			mixed_nibble_tbox_arrays[CEncryption::tbox_size * 2];
+
+	typedef uint16_t						check_array[CEncryption::comb_sbst_size];
+	typedef check_array						check_arrays[CEncryption::tbox_size];
+
 public:
 	enum
 	{
 		tbls_size = sizeof(mixed_comb_tbox_arrays) + sizeof(clear_comb_tbox_arrays) + sizeof(clear_comb_tbox_arrays)
 	};
 
+	// Inverse matrices are linear, so a table indexed by a byte can be split into
+	// two tables indexed by nibbles, rows of which are XORed together
+	enum geometry
+	{
+		byte_geometry,					// 256-row tables (layout of saved private keys)
+		nibble_geometry					// 16-row tables, twice more lookups, about 77 KB instead of 820 KB
+	};
+
 public:
 	CDecryption(const CEncryption&);
 	CDecryption(const CDecryption&);
@@ -133,16 +156,32 @@ public:
 	const CDecryption& operator=(const CDecryption&);
 	
 public:
-	bool init();
+	bool init(geometry = byte_geometry);
+
+	// crpt_size bytes -> msg_size bytes with tables of the selected geometry
+	void decrypt(const uint8_t*, uint8_t*) const;
+	// The same, but returns false for invalid cipher texts. Mix bytes of a valid one are
+	// the XOR of high mixes (a constant) and the XOR of low mixes of the message.
+	// The first one is checked before decryption with a 17 KB table
+	bool decrypt_checked(const uint8_t*, uint8_t*) const;
 	
 public:
 	CEncryption& get_encr();
 	const CEncryption& get_encr() const;
 	bool is_init() const;
+	geometry get_geometry() const;
+	const subst_arrays& get_inv_comb_substs() const;
+	const NBMatrix::TBMatrix<CEncryption::bit_size1, CEncryption::bit_size1>& get_inv_bmtrx1() const;
+	const NBMatrix::TBMatrix<CEncryption::bit_size2, CEncryption::bit_size2>& get_inv_bmtrx2() const;
+
+	// Byte geometry only, std::runtime_error is thrown for another geometry
 	const mixed_comb_tbox_arrays& get_inv_comb_tbxs2() const;
 	const clear_comb_tbox_arrays& get_inv_comb_tbxs1() const;
 	const clear_comb_tbox_arrays& get_final_tbxs() const;
 
+	// Nibble geometry only, std::runtime_error is thrown for another geometry
+	const mixed_nibble_tbox_arrays& get_inv_nibble_tbxs2() const;
+	const clear_nibble_tbox_arrays& get_inv_nibble_tbxs1() const;
 
 private:
 	void gen_inv_matricies();
@@ -150,6 +189,10 @@ private:
 	void gen_inv_tbxs2();
 	void gen_inv_tbxs1();
 	void gen_final_tboxes();
+	void gen_inv_nibble_tbxs2();
+	void gen_inv_nibble_tbxs1();
+	void gen_check_tbxs();
+	void check_geometry(geometry) const;
 
 	template <typename MTRX>
 	void gen_tbox_elem(uint8_t*, int, uint8_t, int);
@@ -171,14 +214,25 @@ private:
 private:
 	CEncryption																m_e;
 	bool																	m_init;
+	geometry																m_geometry;
 	NBMatrix::TBMatrix<CEncryption::bit_size1, CEncryption::bit_size1>		m_inv_bmtrx1;
 	NBMatrix::TBMatrix<CEncryption::bit_size2, CEncryption::bit_size2>		m_inv_bmtrx2;
 	mixed_comb_tbox_arrays													m_inv_comb_tbxs2;	// Use them for multiplying by m_inv_bmtrx2
 	clear_comb_tbox_arrays													m_inv_comb_tbxs1;	// Use them for multiplying by m_inv_bmtrx1
 	subst_arrays															m_inv_comb_substs;	// Use them to get decrypted message
 	clear_comb_tbox_arrays													m_final_tbxs;
+	mixed_nibble_tbox_arrays												m_inv_nibble_tbxs2;
+	clear_nibble_tbox_arrays												m_inv_nibble_tbxs1;
+	check_arrays															m_check_tbxs;		// mix bytes of m_inv_comb_tbxs2 rows
+	uint8_t																	m_high_mix;			// high mix byte of valid cipher texts
 };
 
+// Mix bytes of rows of the inverse second matrix tables (byte geometry)
+void gen_check_tbxs(CDecryption::check_arrays&, const CDecryption::mixed_comb_tbox_arrays&);
+// Low mixes of the combined T-boxes recovered from the public tables with check tables,
+// returns the high mix byte of valid cipher texts
+uint8_t gen_mixes(CEncryption::mix_arrays&, const CEncryption::comb_tbox_arrays&, const CDecryption::check_arrays&);
+
 }
 
 #endif // CIPHER_H
\ No newline at end of file
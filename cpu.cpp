@@ -0,0 +1,149 @@
+//***************************************************************************************
+// cpu.cpp
+// Run-time detection of CPU features
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "cpu.h"
+#include <stdint.h>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define WB_X86
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#define WB_X86
+#endif
+
+namespace NCpu
+{
+
+struct SFeatures
+{
+	bool sse41;
+	bool sha;
+	bool avx2;
+	bool avx512f;
+	bool avx512bw;
+	bool gfni;
+};
+
+#ifdef WB_X86
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* regs)
+{
+#ifdef _MSC_VER
+	__cpuidex((int*)regs, (int)leaf, (int)subleaf);
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif // _MSC_VER
+}
+
+// Register states enabled by OS
+static uint64_t xgetbv()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t lo, hi;
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+
+	return ((uint64_t)hi << 32) | lo;
+#endif // _MSC_VER
+}
+
+static SFeatures get_features()
+{
+	SFeatures f = { false, false, false, false, false, false };
+	uint32_t regs[4];
+
+	cpuid(0, 0, regs);
+	if (regs[0] < 7)
+		return f;
+
+	cpuid(1, 0, regs);
+	f.sse41 = (regs[2] & (1u << 19)) != 0;
+
+	cpuid(7, 0, regs);
+	f.sha = (regs[1] & (1u << 29)) != 0;
+
+	cpuid(1, 0, regs);
+	bool osxsave = (regs[2] & (1u << 27)) != 0;
+	bool avx = (regs[2] & (1u << 28)) != 0;
+	if (!osxsave || !avx)
+		return f;
+
+	uint64_t xcr0 = xgetbv();
+	bool ymm = (xcr0 & 0x06) == 0x06;
+	bool zmm = (xcr0 & 0xe6) == 0xe6;
+
+	cpuid(7, 0, regs);
+	f.avx2 = ymm && (regs[1] & (1u << 5)) != 0;
+	f.avx512f = zmm && (regs[1] & (1u << 16)) != 0;
+	f.avx512bw = zmm && (regs[1] & (1u << 30)) != 0;
+	f.gfni = ymm && (regs[2] & (1u << 8)) != 0;		// only VEX and EVEX encodings are used
+
+	return f;
+}
+
+#else
+
+static SFeatures get_features()
+{
+	SFeatures f = { false, false, false, false, false, false };
+
+	return f;
+}
+
+#endif // WB_X86
+
+static const SFeatures features = get_features();
+
+bool has_sse41()
+{
+	return features.sse41;
+}
+
+bool has_sha()
+{
+	return features.sha;
+}
+
+bool has_avx2()
+{
+	return features.avx2;
+}
+
+bool has_avx512f()
+{
+	return features.avx512f;
+}
+
+bool has_avx512bw()
+{
+	return features.avx512bw;
+}
+
+bool has_gfni()
+{
+	return features.gfni;
+}
+
+}
@@ -0,0 +1,67 @@
+//***************************************************************************************
+// cpu.h
+// Run-time detection of CPU features
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#ifndef CPU_H
+#define CPU_H
+
+//
+// Compiler support of instruction set extensions. GCC and Clang compile a function which
+// uses an extension for its own target (WB_TARGET), so the rest of the program does not
+// require it, MSVC accepts intrinsics anywhere. Code paths are selected at run time
+//
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define WB_TARGET(t) __attribute__((target(t)))
+#define WB_FLATTEN __attribute__((flatten))
+#define WB_HAS_AVX2
+#define WB_HAS_SHA
+#if __GNUC__ >= 8 || defined(__clang__)
+#define WB_HAS_GFNI
+#endif
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define WB_TARGET(t)
+#define WB_FLATTEN
+#if _MSC_VER >= 1700							// Visual Studio 2012
+#define WB_HAS_AVX2
+#endif
+#if _MSC_VER >= 1900							// Visual Studio 2015
+#define WB_HAS_SHA
+#endif
+#if _MSC_VER >= 1920							// Visual Studio 2019, also AVX-512
+#define WB_HAS_GFNI
+#endif
+#endif
+
+namespace NCpu
+{
+
+// Features are detected once, a feature is reported only if both CPU and OS support it
+bool has_sse41();
+bool has_sha();
+bool has_avx2();
+bool has_avx512f();
+bool has_avx512bw();
+bool has_gfni();
+
+}
+
+#endif // CPU_H
@@ -0,0 +1,259 @@
+//***************************************************************************************
+// crypt.cpp
+// Encryption and decryption of messages with public and private tables
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "crypt.h"
+#include "tblrow.h"
+
+namespace NCrypt
+{
+
+CPrivKey::CPrivKey(const NCipher::CDecryption& d) : m_tbxs2(&d.get_inv_comb_tbxs2()), m_tbxs1(&d.get_inv_comb_tbxs1()),
+	m_tbxs0(&d.get_final_tbxs())
+{
+}
+
+CPrivKey::CPrivKey(const uint8_t* buf)
+{
+	m_tbxs2 = (const NCipher::CDecryption::mixed_comb_tbox_arrays*)buf;
+	buf += sizeof(NCipher::CDecryption::mixed_comb_tbox_arrays);
+	m_tbxs1 = (const NCipher::CDecryption::clear_comb_tbox_arrays*)buf;
+	buf += sizeof(NCipher::CDecryption::clear_comb_tbox_arrays);
+	m_tbxs0 = (const NCipher::CDecryption::clear_comb_tbox_arrays*)buf;
+}
+
+const NCipher::CDecryption::mixed_comb_tbox_arrays& CPrivKey::get_inv_comb_tbxs2() const
+{
+	return *m_tbxs2;
+}
+
+const NCipher::CDecryption::clear_comb_tbox_arrays& CPrivKey::get_inv_comb_tbxs1() const
+{
+	return *m_tbxs1;
+}
+
+const NCipher::CDecryption::clear_comb_tbox_arrays& CPrivKey::get_final_tbxs() const
+{
+	return *m_tbxs0;
+}
+
+const pub_key& get_pub_key(const uint8_t* buf)
+{
+	return *((const pub_key*)buf);
+}
+
+//
+// out = XOR of tbls[i][in[i]] for i < IN
+//
+template <int IN, int OUT, typename TBLS>
+static void xor_tbls(const TBLS& tbls, const uint8_t* in, uint8_t* out)
+{
+	uint64_t acc[TRow<OUT>::lanes];
+	clear_row<OUT>(acc);
+
+	for (int i = 0; i < IN; ++i)
+		xor_row<OUT>(acc, tbls[i][in[i]]);
+
+	store_row<OUT>(out, acc);
+}
+
+void encrypt(const pub_key& key, const uint8_t* msg, uint8_t* crpt)
+{
+	xor_tbls<msg_size, crpt_size>(key, msg, crpt);
+}
+
+void decrypt(const CPrivKey& key, const uint8_t* crpt, uint8_t* msg)
+{
+	uint8_t t0[crpt_size];
+	uint8_t t1[msg_size];
+
+	xor_tbls<crpt_size, crpt_size>(key.get_inv_comb_tbxs2(), crpt, t0);
+	xor_tbls<msg_size, msg_size>(key.get_inv_comb_tbxs1(), t0, t1);
+	xor_tbls<msg_size, msg_size>(key.get_final_tbxs(), t1, msg);
+}
+
+typedef TAllPositions<crpt_size>	crpt_positions;
+typedef TAllPositions<msg_size>		msg_positions;
+
+static size_t group_size(size_t pos, size_t n)
+{
+	return (n - pos < batch_width) ? n - pos : batch_width;
+}
+
+void encrypt_batch(const pub_key& key, const uint8_t* msgs, size_t n, uint8_t* crpts)
+{
+	xor_rows_batch<crpt_size, batch_width>(key, msg_positions(), nullptr, msgs, msg_size, n, crpts);
+}
+
+void decrypt_batch(const CPrivKey& key, const uint8_t* crpts, size_t n, uint8_t* msgs)
+{
+	if (!n)
+		return;
+
+	// Intermediate results of two consecutive groups
+	uint8_t t0[2][batch_width * crpt_size];
+	uint8_t t1[2][batch_width * msg_size];
+
+	size_t groups = (n + batch_width - 1) / batch_width;
+
+	prefetch_rows<crpt_size>(key.get_inv_comb_tbxs2(), crpt_positions(), crpts, crpt_size, group_size(0, n));
+
+	// Row indices of a stage are known only after the previous stage, so stages of
+	// consecutive groups are overlapped: group g is multiplied by the second matrix while
+	// group g - 1 is multiplied by the first one and group g - 2 is substituted.
+	// Rows of every stage are prefetched one group before they are used
+	for (size_t g = 0; g < groups + 2; ++g)
+	{
+		if (g < groups)
+		{
+			size_t pos = g * batch_width;
+			size_t cnt = group_size(pos, n);
+			size_t next = pos + batch_width;
+
+			if (next < n)
+				prefetch_rows<crpt_size>(key.get_inv_comb_tbxs2(), crpt_positions(), crpts + next * crpt_size, crpt_size, group_size(next, n));
+
+			// Multiply by inverse of the second matrix
+			xor_rows<crpt_size, batch_width>(key.get_inv_comb_tbxs2(), crpt_positions(), nullptr, crpts + pos * crpt_size, crpt_size, cnt,
+				t0[g & 1]);
+			prefetch_rows<msg_size>(key.get_inv_comb_tbxs1(), msg_positions(), t0[g & 1], crpt_size, cnt);
+		}
+
+		if (g >= 1 && g <= groups)
+		{
+			size_t cnt = group_size((g - 1) * batch_width, n);
+
+			// Multiply by inverse of the first matrix
+			xor_rows<msg_size, batch_width>(key.get_inv_comb_tbxs1(), msg_positions(), nullptr, t0[(g - 1) & 1], crpt_size, cnt,
+				t1[(g - 1) & 1]);
+			prefetch_rows<msg_size>(key.get_final_tbxs(), msg_positions(), t1[(g - 1) & 1], msg_size, cnt);
+		}
+
+		if (g >= 2)
+		{
+			size_t pos = (g - 2) * batch_width;
+
+			// Inverse substitution
+			xor_rows<msg_size, batch_width>(key.get_final_tbxs(), msg_positions(), nullptr, t1[g & 1], msg_size, group_size(pos, n),
+				msgs + pos * msg_size);
+		}
+	}
+}
+
+//
+// Prefetch rows of cnt keys for the same message
+//
+static void prefetch_keys(const pub_key* const* keys, size_t cnt, const uint8_t* msg)
+{
+	for (size_t k = 0; k < cnt; ++k)
+	{
+		for (int i = 0; i < msg_size; ++i)
+			prefetch_row<crpt_size>((*keys[k])[i][msg[i]]);
+	}
+}
+
+void encrypt_multi(const pub_key* const* keys, size_t nkeys, const uint8_t* msg, uint8_t* crpts)
+{
+	if (!nkeys)
+		return;
+
+	prefetch_keys(keys, group_size(0, nkeys), msg);
+
+	for (size_t pos = 0; pos < nkeys; pos += batch_width)
+	{
+		size_t cnt = group_size(pos, nkeys);
+		size_t next = pos + batch_width;
+
+		if (next < nkeys)
+			prefetch_keys(keys + next, group_size(next, nkeys), msg);
+
+		uint64_t acc[batch_width][TRow<crpt_size>::lanes];
+		for (size_t k = 0; k < cnt; ++k)
+			clear_row<crpt_size>(acc[k]);
+
+		for (int i = 0; i < msg_size; ++i)
+		{
+			for (size_t k = 0; k < cnt; ++k)
+				xor_row<crpt_size>(acc[k], (*keys[pos + k])[i][msg[i]]);
+		}
+
+		for (size_t k = 0; k < cnt; ++k)
+			store_row<crpt_size>(crpts + (pos + k) * crpt_size, acc[k]);
+	}
+}
+
+void encrypt_multi_parallel(NExec::CExecutor& exec, const pub_key* const* keys, size_t nkeys, const uint8_t* msg, uint8_t* crpts)
+{
+	exec.parallel_for(nkeys, multi_grain, [&](size_t begin, size_t end)
+	{
+		encrypt_multi(keys + begin, end - begin, msg, crpts + begin * crpt_size);
+	});
+}
+
+void update_ciphertext(const pub_key& key, uint8_t* crpt, int pos, uint8_t old_val, uint8_t new_val)
+{
+	if (old_val == new_val)
+		return;
+
+	uint64_t acc[TRow<crpt_size>::lanes];
+	load_row<crpt_size>(acc, crpt);
+	xor_row<crpt_size>(acc, key[pos][old_val]);
+	xor_row<crpt_size>(acc, key[pos][new_val]);
+	store_row<crpt_size>(crpt, acc);
+}
+
+void update_ciphertext(const pub_key& key, uint8_t* crpt, const uint8_t* old_msg, const uint8_t* new_msg)
+{
+	uint32_t m = get_diff_mask32(old_msg, new_msg);
+	if (!m)
+		return;
+
+	uint64_t acc[TRow<crpt_size>::lanes];
+	load_row<crpt_size>(acc, crpt);
+
+	while (m)
+	{
+		int i = pop_lowest_bit(m);
+		xor_row<crpt_size>(acc, key[i][old_msg[i]]);
+		xor_row<crpt_size>(acc, key[i][new_msg[i]]);
+	}
+
+	store_row<crpt_size>(crpt, acc);
+}
+
+void encrypt_parallel(NExec::CExecutor& exec, const pub_key& key, const uint8_t* msgs, size_t n, uint8_t* crpts)
+{
+	exec.parallel_for(n, parallel_grain, [&](size_t begin, size_t end)
+	{
+		encrypt_batch(key, msgs + begin * msg_size, end - begin, crpts + begin * crpt_size);
+	});
+}
+
+void decrypt_parallel(NExec::CExecutor& exec, const CPrivKey& key, const uint8_t* crpts, size_t n, uint8_t* msgs)
+{
+	exec.parallel_for(n, parallel_grain, [&](size_t begin, size_t end)
+	{
+		decrypt_batch(key, crpts + begin * crpt_size, end - begin, msgs + begin * msg_size);
+	});
+}
+
+}
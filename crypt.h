@@ -0,0 +1,98 @@
+//***************************************************************************************
+// crypt.h
+// Encryption and decryption of messages with public and private tables
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "cipher.h"
+#include "executor.h"
+
+#ifndef CRYPT_H
+#define CRYPT_H
+
+namespace NCrypt
+{
+
+enum
+{
+	msg_size = NCipher::CEncryption::comb_sbsts_num,		// Size of a plain message (in bytes)
+	crpt_size = NCipher::CEncryption::tbox_size,		// Size of an encrypted message (in bytes)
+	batch_width = 4,									// Number of messages processed together by batch functions
+	parallel_grain = 1024,								// Number of messages in one task of parallel functions
+	multi_grain = 16									// Number of keys in one task of parallel multi-recipient encryption
+};
+
+typedef NCipher::CEncryption::comb_tbox_arrays pub_key;
+
+//
+// Private key tables (layout of NSaveKeys::save_private_key)
+//
+class CPrivKey
+{
+public:
+	CPrivKey(const NCipher::CDecryption&);
+	CPrivKey(const uint8_t*);				// a buffer returned by NSaveKeys::load_priv_key
+
+public:
+	const NCipher::CDecryption::mixed_comb_tbox_arrays& get_inv_comb_tbxs2() const;
+	const NCipher::CDecryption::clear_comb_tbox_arrays& get_inv_comb_tbxs1() const;
+	const NCipher::CDecryption::clear_comb_tbox_arrays& get_final_tbxs() const;
+
+private:
+	const NCipher::CDecryption::mixed_comb_tbox_arrays	*m_tbxs2;
+	const NCipher::CDecryption::clear_comb_tbox_arrays	*m_tbxs1;
+	const NCipher::CDecryption::clear_comb_tbox_arrays	*m_tbxs0;
+};
+
+// A buffer returned by NSaveKeys::load_public_key
+const pub_key& get_pub_key(const uint8_t*);
+
+// msg_size bytes -> crpt_size bytes
+void encrypt(const pub_key&, const uint8_t*, uint8_t*);
+// crpt_size bytes -> msg_size bytes
+void decrypt(const CPrivKey&, const uint8_t*, uint8_t*);
+
+// n messages of msg_size bytes -> n messages of crpt_size bytes
+// Row addresses of several messages are computed and prefetched ahead of use,
+// so many cache misses are outstanding at once
+void encrypt_batch(const pub_key&, const uint8_t*, size_t, uint8_t*);
+// n messages of crpt_size bytes -> n messages of msg_size bytes
+void decrypt_batch(const CPrivKey&, const uint8_t*, size_t, uint8_t*);
+
+// The same as batch functions, messages are split between workers of the executor
+// Keys are shared by all workers and must not be changed during the call
+void encrypt_parallel(NExec::CExecutor&, const pub_key&, const uint8_t*, size_t, uint8_t*);
+void decrypt_parallel(NExec::CExecutor&, const CPrivKey&, const uint8_t*, size_t, uint8_t*);
+
+// One message of msg_size bytes -> nkeys messages of crpt_size bytes, one per key
+// Rows of several keys are fetched interleaved and the next keys are prefetched ahead
+void encrypt_multi(const pub_key* const* keys, size_t nkeys, const uint8_t* msg, uint8_t* crpts);
+// The same, keys are split between workers of the executor
+void encrypt_multi_parallel(NExec::CExecutor&, const pub_key* const* keys, size_t nkeys, const uint8_t* msg, uint8_t* crpts);
+
+// Encryption is XOR of rows selected by message bytes, so a change of byte pos
+// from old_val to new_val is applied as crpt ^= row(pos, old_val) ^ row(pos, new_val)
+void update_ciphertext(const pub_key&, uint8_t* crpt, int pos, uint8_t old_val, uint8_t new_val);
+// The message changed from old_msg to new_msg, only changed bytes cost row lookups
+void update_ciphertext(const pub_key&, uint8_t* crpt, const uint8_t* old_msg, const uint8_t* new_msg);
+
+}
+
+#endif // CRYPT_H
@@ -0,0 +1,283 @@
+//***************************************************************************************
+// executor.cpp
+// Work-stealing thread pool
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "executor.h"
+#include <memory>
+
+#ifdef WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif // WIN32
+
+namespace NExec
+{
+
+bool set_thread_affinity(std::thread& t, unsigned int cpu)
+{
+#ifdef WIN32
+	if (cpu >= sizeof(DWORD_PTR) << 3)
+		return false;
+
+	return ::SetThreadAffinityMask(t.native_handle(), ((DWORD_PTR)1) << cpu) != 0;
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+
+	return !pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+	return false;
+#endif // WIN32
+}
+
+void CExecutor::CWorkQueue::push(const task& t)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_tasks.push_back(t);
+}
+
+bool CExecutor::CWorkQueue::pop(task& t)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (m_tasks.empty())
+		return false;
+
+	t = m_tasks.back();
+	m_tasks.pop_back();
+
+	return true;
+}
+
+bool CExecutor::CWorkQueue::steal(task& t)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (m_tasks.empty())
+		return false;
+
+	t = m_tasks.front();
+	m_tasks.pop_front();
+
+	return true;
+}
+
+CExecutor::CExecutor(unsigned int threads_num) : m_pending(0), m_stop(false)
+{
+	if (!threads_num)
+		threads_num = std::thread::hardware_concurrency();
+	if (!threads_num)
+		threads_num = 1;
+
+	start(threads_num, nullptr);
+}
+
+CExecutor::CExecutor(const std::vector<unsigned int>& cpus) : m_pending(0), m_stop(false)
+{
+	if (cpus.empty())
+		start(1, nullptr);
+	else
+		start((unsigned int)cpus.size(), &cpus[0]);
+}
+
+CExecutor::~CExecutor()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_cv.notify_all();
+
+	for (size_t i = 0; i < m_threads.size(); ++i)
+		m_threads[i].join();
+
+	for (size_t i = 0; i < m_queues.size(); ++i)
+		delete m_queues[i];
+}
+
+void CExecutor::start(unsigned int threads_num, const unsigned int* cpus)
+{
+	for (unsigned int i = 0; i < threads_num; ++i)
+		m_queues.push_back(new CWorkQueue());
+
+	// Queues must exist before any worker looks for a task
+	for (unsigned int i = 0; i < threads_num; ++i)
+	{
+		m_threads.push_back(std::thread(&CExecutor::work, this, i));
+		if (cpus)
+			set_thread_affinity(m_threads.back(), cpus[i]);
+	}
+}
+
+unsigned int CExecutor::get_threads_num() const
+{
+	return (unsigned int)m_threads.size();
+}
+
+int CExecutor::get_self() const
+{
+	std::thread::id id = std::this_thread::get_id();
+	for (size_t i = 0; i < m_threads.size(); ++i)
+	{
+		if (m_threads[i].get_id() == id)
+			return (int)i;
+	}
+
+	return -1;
+}
+
+void CExecutor::submit(const task& t)
+{
+	// Workers keep their tasks local, tasks of other threads are shared and run in order
+	int self = get_self();
+	CWorkQueue& q(self >= 0 ? *m_queues[self] : m_shared);
+
+	// The task is counted before it becomes visible, so a thief never decrements first
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		++m_pending;
+	}
+
+	q.push(t);
+	m_cv.notify_one();
+}
+
+bool CExecutor::try_run(int self)
+{
+	task t;
+	bool found = (self >= 0 && m_queues[self]->pop(t)) || m_shared.steal(t);
+
+	// Steal starting from the next worker, so thieves do not crowd one queue
+	size_t first = self >= 0 ? (size_t)self + 1 : 0;
+	for (size_t i = 0; !found && i < m_queues.size(); ++i)
+		found = m_queues[(first + i) % m_queues.size()]->steal(t);
+
+	if (!found)
+		return false;
+
+	--m_pending;
+	t();
+
+	return true;
+}
+
+void CExecutor::work(unsigned int self)
+{
+	for (;;)
+	{
+		if (try_run((int)self))
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_mtx);
+		while (!m_stop && !m_pending)
+			m_cv.wait(lock);
+
+		// Queued tasks are run before the worker stops. A task which is counted and not
+		// pushed yet is found on the next try
+		if (m_stop && !m_pending)
+			return;
+	}
+}
+
+void CExecutor::parallel_for(size_t n, size_t grain, const range_task& fn)
+{
+	if (!n)
+		return;
+	if (!grain)
+		grain = 1;
+
+	//
+	// Chunks are claimed by their numbers, tasks of the loop (and the caller) run chunks
+	// until all of them are claimed. A task which runs after that returns at once,
+	// so the state is shared with tasks which may outlive the call
+	//
+	struct SLoop
+	{
+		const range_task			*fn;				// used only for a claimed chunk, so it is alive
+		size_t						n;
+		size_t						grain;
+		size_t						chunks;
+		std::atomic<size_t>			next;				// the next chunk to claim
+		std::mutex					mtx;
+		std::condition_variable		cv;
+		size_t						remaining;			// chunks which are not done
+		std::exception_ptr			error;				// the first exception thrown by fn
+
+		void run()
+		{
+			for (size_t i = next++; i < chunks; i = next++)
+			{
+				size_t begin = i * grain;
+				size_t end = (n - begin < grain) ? n : begin + grain;
+
+				// A chunk is counted down even if fn throws, otherwise the caller waits forever
+				std::exception_ptr e;
+				try
+				{
+					(*fn)(begin, end);
+				}
+				catch (...)
+				{
+					e = std::current_exception();
+				}
+
+				std::lock_guard<std::mutex> lock(mtx);
+				if (e && !error)
+					error = e;
+				if (!--remaining)
+					cv.notify_all();
+			}
+		}
+	};
+
+	std::shared_ptr<SLoop> loop(new SLoop());
+	loop->fn = &fn;
+	loop->n = n;
+	loop->grain = grain;
+	loop->chunks = (n + grain - 1) / grain;
+	loop->next = 0;
+	loop->remaining = loop->chunks;
+
+	// The caller runs chunks too, so one task less than chunks is enough
+	size_t tasks = loop->chunks - 1 < m_threads.size() ? loop->chunks - 1 : m_threads.size();
+	for (size_t i = 0; i < tasks; ++i)
+	{
+		submit([loop]()
+		{
+			loop->run();
+		});
+	}
+
+	loop->run();
+
+	// Only chunks claimed by other threads are left, they are running already
+	std::unique_lock<std::mutex> lock(loop->mtx);
+	while (loop->remaining)
+		loop->cv.wait(lock);
+
+	// Rethrow on the calling thread
+	if (loop->error)
+		std::rethrow_exception(loop->error);
+}
+
+}
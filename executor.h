@@ -0,0 +1,104 @@
+//***************************************************************************************
+// executor.h
+// Work-stealing thread pool
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+namespace NExec
+{
+
+//
+// Every worker owns a queue of tasks. A worker takes its own tasks from the back
+// of its queue, then tasks of other threads in order of submission, and steals tasks
+// of other workers from the front of their queues
+//
+class CExecutor
+{
+public:
+	typedef std::function<void()>					task;
+	typedef std::function<void(size_t, size_t)>		range_task;
+
+public:
+	CExecutor(unsigned int threads_num = 0);					// 0 - use all hardware threads
+	CExecutor(const std::vector<unsigned int>& cpus);			// one worker pinned to every cpu
+	~CExecutor();												// runs all queued tasks, then joins workers
+
+private:
+	CExecutor(const CExecutor&);
+	const CExecutor& operator=(const CExecutor&);
+
+public:
+	unsigned int get_threads_num() const;
+
+	void submit(const task&);
+
+	// Call fn(begin, end) for chunks of [0, n) no longer than grain
+	// The calling thread takes part in the work and returns when all chunks are done.
+	// It runs only chunks of this loop, so it never waits for unrelated tasks
+	// If fn throws, the remaining chunks still run and the first exception is rethrown here
+	void parallel_for(size_t n, size_t grain, const range_task& fn);
+
+private:
+	class CWorkQueue
+	{
+	public:
+		void push(const task&);
+		bool pop(task&);
+		bool steal(task&);
+
+	private:
+		std::mutex			m_mtx;
+		std::deque<task>	m_tasks;
+	};
+
+private:
+	void start(unsigned int, const unsigned int*);
+	void work(unsigned int);
+	int get_self() const;
+	bool try_run(int);
+
+private:
+	std::vector<std::thread>		m_threads;
+	std::vector<CWorkQueue*>		m_queues;
+	CWorkQueue						m_shared;			// tasks submitted by other threads
+	std::mutex						m_mtx;
+	std::condition_variable			m_cv;
+	std::atomic<size_t>				m_pending;
+	bool							m_stop;
+};
+
+bool set_thread_affinity(std::thread&, unsigned int);
+
+}
+
+#endif // EXECUTOR_H
@@ -0,0 +1,238 @@
+//***************************************************************************************
+// gfdecr.cpp
+// Decryption with GF2P8AFFINEQB (GFNI) evaluating 8x8 blocks of inverse matrices
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "gfdecr.h"
+#include "cpu.h"
+#include <string.h>
+
+#ifdef WB_HAS_GFNI
+#include <immintrin.h>
+#endif // WB_HAS_GFNI
+
+namespace NCrypt
+{
+
+typedef uint64_t affine2_arrays[crpt_size][msg_size];
+typedef uint64_t affine1_arrays[msg_size][msg_size];
+
+//
+// Block (r, c) of a matrix as GF2P8AFFINEQB operand: byte 7 - i holds bits 8c..8c+7 of row 8r+i
+//
+template <typename MTRX>
+static uint64_t get_affine(const MTRX& m, int r, int c)
+{
+	uint64_t a(0);
+	for (int i = 0; i < 8; ++i)
+	{
+		uint64_t row = (m[(r << 3) + i].get_internal_array()[c >> 3] >> ((c & 7) << 3)) & 0xff;
+		a |= row << ((7 - i) << 3);
+	}
+
+	return a;
+}
+
+//
+// GF2P8AFFINEQB with zero constant: bit i of every byte of the result is parity of the byte ANDed with byte 7 - i of a
+//
+static uint64_t affine_u64(uint64_t x, uint64_t a)
+{
+	const uint64_t ones = 0x0101010101010101ull;
+	uint64_t res(0);
+
+	for (int i = 0; i < 8; ++i)
+	{
+		uint64_t t = x & (((a >> ((7 - i) << 3)) & 0xff) * ones);
+		t ^= t >> 4;
+		t ^= t >> 2;
+		t ^= t >> 1;
+		res |= (t & ones) << i;
+	}
+
+	return res;
+}
+
+template <int IN>
+static void mul_scalar(const uint64_t (*a)[msg_size], const uint64_t* in, uint64_t* out)
+{
+	for (int r = 0; r < msg_size; ++r)
+		out[r] = 0;
+
+	for (int c = 0; c < IN; ++c)
+	{
+		for (int r = 0; r < msg_size; ++r)
+			out[r] ^= affine_u64(in[c], a[c][r]);
+	}
+}
+
+#ifdef WB_HAS_GFNI
+
+template <int IN>
+WB_TARGET("gfni,avx2") static void mul_avx2(const uint64_t (*a)[msg_size], const uint64_t* in, uint64_t* out)
+{
+	__m256i acc[msg_size / 4];
+	for (int g = 0; g < msg_size / 4; ++g)
+		acc[g] = _mm256_setzero_si256();
+
+	for (int c = 0; c < IN; ++c)
+	{
+		__m256i x = _mm256_set1_epi64x((long long)in[c]);
+		for (int g = 0; g < msg_size / 4; ++g)
+		{
+			__m256i m = _mm256_loadu_si256((const __m256i*)(a[c] + (g << 2)));
+			acc[g] = _mm256_xor_si256(acc[g], _mm256_gf2p8affine_epi64_epi8(x, m, 0));
+		}
+	}
+
+	for (int g = 0; g < msg_size / 4; ++g)
+		_mm256_storeu_si256((__m256i*)(out + (g << 2)), acc[g]);
+}
+
+template <int IN>
+WB_TARGET("gfni,avx512f,avx512bw") static void mul_avx512(const uint64_t (*a)[msg_size], const uint64_t* in, uint64_t* out)
+{
+	__m512i acc[msg_size / 8];
+	for (int g = 0; g < msg_size / 8; ++g)
+		acc[g] = _mm512_setzero_si512();
+
+	for (int c = 0; c < IN; ++c)
+	{
+		__m512i x = _mm512_set1_epi64((long long)in[c]);
+		for (int g = 0; g < msg_size / 8; ++g)
+		{
+			__m512i m = _mm512_loadu_si512((const void*)(a[c] + (g << 3)));
+			acc[g] = _mm512_xor_si512(acc[g], _mm512_gf2p8affine_epi64_epi8(x, m, 0));
+		}
+	}
+
+	for (int g = 0; g < msg_size / 8; ++g)
+		_mm512_storeu_si512((void*)(out + (g << 3)), acc[g]);
+}
+
+#endif // WB_HAS_GFNI
+
+CGfniDecryption::CGfniDecryption(const NCipher::CDecryption& d) : m_backend(get_best_backend())
+{
+	// Only the first msg_size bytes of the product by the inverse second matrix are used (the rest are mix bytes)
+	for (int c = 0; c < crpt_size; ++c)
+	{
+		for (int r = 0; r < msg_size; ++r)
+			m_affine2[c][r] = get_affine(d.get_inv_bmtrx2(), r, c);
+	}
+
+	for (int c = 0; c < msg_size; ++c)
+	{
+		for (int r = 0; r < msg_size; ++r)
+			m_affine1[c][r] = get_affine(d.get_inv_bmtrx1(), r, c);
+	}
+
+	memcpy(m_inv_substs, d.get_inv_comb_substs(), sizeof(m_inv_substs));
+}
+
+CGfniDecryption::backend CGfniDecryption::get_best_backend()
+{
+#ifdef WB_HAS_GFNI
+	if (NCpu::has_gfni() && NCpu::has_avx512f() && NCpu::has_avx512bw())
+		return avx512_backend;
+
+	if (NCpu::has_gfni() && NCpu::has_avx2())
+		return avx2_backend;
+#endif // WB_HAS_GFNI
+
+	return scalar_backend;
+}
+
+CGfniDecryption::backend CGfniDecryption::get_backend() const
+{
+	return m_backend;
+}
+
+bool CGfniDecryption::set_backend(backend b)
+{
+	if (b > get_best_backend())
+		return false;
+
+	m_backend = b;
+
+	return true;
+}
+
+void CGfniDecryption::decrypt_lanes(const uint64_t* in, uint64_t* out) const
+{
+	uint64_t t[msg_size];
+
+#ifdef WB_HAS_GFNI
+	if (m_backend == avx512_backend)
+	{
+		mul_avx512<crpt_size>(m_affine2, in, t);
+		mul_avx512<msg_size>(m_affine1, t, out);
+
+		return;
+	}
+
+	if (m_backend == avx2_backend)
+	{
+		mul_avx2<crpt_size>(m_affine2, in, t);
+		mul_avx2<msg_size>(m_affine1, t, out);
+
+		return;
+	}
+#endif // WB_HAS_GFNI
+
+	mul_scalar<crpt_size>(m_affine2, in, t);
+	mul_scalar<msg_size>(m_affine1, t, out);
+}
+
+void CGfniDecryption::decrypt(const uint8_t* crpt, uint8_t* msg) const
+{
+	decrypt_batch(crpt, 1, msg);
+}
+
+void CGfniDecryption::decrypt_batch(const uint8_t* crpts, size_t n, uint8_t* msgs) const
+{
+	uint64_t in[crpt_size];
+	uint64_t out[msg_size];
+
+	for (size_t pos = 0; pos < n; pos += group_size)
+	{
+		size_t cnt = n - pos < group_size ? n - pos : group_size;
+
+		// Byte c of message k -> byte k of lane c
+		memset(in, 0, sizeof(in));
+		for (size_t k = 0; k < cnt; ++k)
+		{
+			for (int c = 0; c < crpt_size; ++c)
+				((uint8_t*)(in + c))[k] = crpts[(pos + k) * crpt_size + c];
+		}
+
+		decrypt_lanes(in, out);
+
+		// Inverse substitution
+		for (size_t k = 0; k < cnt; ++k)
+		{
+			for (int r = 0; r < msg_size; ++r)
+				msgs[(pos + k) * msg_size + r] = m_inv_substs[r][((uint8_t*)(out + r))[k]];
+		}
+	}
+}
+
+}
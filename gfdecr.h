@@ -0,0 +1,82 @@
+//***************************************************************************************
+// gfdecr.h
+// Decryption with GF2P8AFFINEQB (GFNI) evaluating 8x8 blocks of inverse matrices
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "crypt.h"
+
+#ifndef GFDECR_H
+#define GFDECR_H
+
+namespace NCrypt
+{
+
+//
+// Byte r of a product of a matrix and a vector is XOR of products of 8x8 blocks (r, c) and bytes c.
+// GF2P8AFFINEQB multiplies every byte of a 64-bit lane by an 8x8 block stored in the lane,
+// so messages are processed in groups of 8: lane c holds byte c of all 8 messages.
+// Linear stages do no memory lookups, only inverse S-boxes are looked up
+//
+class CGfniDecryption
+{
+public:
+	enum
+	{
+		group_size = 8								// Number of messages in a lane
+	};
+
+	enum backend
+	{
+		scalar_backend,								// 64-bit emulation of GF2P8AFFINEQB (bit-exact)
+		avx2_backend,								// GFNI with 256-bit vectors
+		avx512_backend								// GFNI with 512-bit vectors
+	};
+
+public:
+	// The best backend supported by CPU is selected
+	CGfniDecryption(const NCipher::CDecryption&);
+
+public:
+	static backend get_best_backend();
+
+	backend get_backend() const;
+	// Returns false if CPU does not support the backend
+	bool set_backend(backend);
+
+public:
+	// crpt_size bytes -> msg_size bytes
+	void decrypt(const uint8_t*, uint8_t*) const;
+	void decrypt_batch(const uint8_t*, size_t, uint8_t*) const;
+
+private:
+	// Lanes of group_size messages
+	void decrypt_lanes(const uint64_t*, uint64_t*) const;
+
+private:
+	uint64_t								m_affine2[crpt_size][msg_size];		// block (r, c) of the inverse second matrix at [c][r]
+	uint64_t								m_affine1[msg_size][msg_size];		// block (r, c) of the inverse first matrix at [c][r]
+	NCipher::CDecryption::subst_arrays		m_inv_substs;
+	backend									m_backend;
+};
+
+}
+
+#endif // GFDECR_H
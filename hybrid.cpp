@@ -0,0 +1,85 @@
+//***************************************************************************************
+// hybrid.cpp
+// Hybrid encryption: a session key is encrypted with public tables,
+// a message is encrypted with ChaCha20-Poly1305 under the session key
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "hybrid.h"
+#include <string.h>
+
+namespace NCrypt
+{
+
+static const uint8_t zero_nonce[NChaCha::nonce_size] = { 0 };
+
+size_t get_hybrid_crypt_size(size_t len)
+{
+	return crpt_size + len + NChaCha::tag_size;
+}
+
+size_t get_hybrid_msg_size(size_t len)
+{
+	return len < crpt_size + NChaCha::tag_size ? 0 : len - crpt_size - NChaCha::tag_size;
+}
+
+bool hybrid_encrypt(const pub_key& key, const uint8_t* msg, size_t len, uint8_t* out, size_t out_size)
+{
+#ifndef WIN32
+	// NPrng::get_rnd does not fill the buffer outside WIN32, so the session key would be
+	// predictable and, with the zero nonce, every message would reuse the same key stream
+	return false;
+#else
+	if (out_size < get_hybrid_crypt_size(len))
+		return false;
+
+	uint8_t session_key[msg_size];
+	NPrng::get_rnd(session_key, sizeof(session_key));
+
+	encrypt(key, session_key, out);
+	NChaCha::aead_encrypt(session_key, zero_nonce, out, crpt_size, msg, len, out + crpt_size, out + crpt_size + len);
+
+	memset(session_key, 0, sizeof(session_key));
+
+	return true;
+#endif // WIN32
+}
+
+bool hybrid_decrypt(const CPrivKey& key, const uint8_t* crpt, size_t len, uint8_t* out, size_t out_size)
+{
+	if (len < crpt_size + NChaCha::tag_size)
+		return false;
+
+	size_t msg_len = get_hybrid_msg_size(len);
+	if (out_size < msg_len)
+		return false;
+
+	uint8_t session_key[msg_size];
+	decrypt(key, crpt, session_key);
+
+	bool ok = NChaCha::aead_decrypt(session_key, zero_nonce, crpt, crpt_size, crpt + crpt_size, msg_len, out,
+		crpt + crpt_size + msg_len);
+
+	memset(session_key, 0, sizeof(session_key));
+
+	return ok;
+}
+
+}
@@ -0,0 +1,50 @@
+//***************************************************************************************
+// hybrid.h
+// Hybrid encryption: a session key is encrypted with public tables,
+// a message is encrypted with ChaCha20-Poly1305 under the session key
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "crypt.h"
+#include "chacha.h"
+
+#ifndef HYBRID_H
+#define HYBRID_H
+
+namespace NCrypt
+{
+
+//
+// Encrypted message: encrypted session key (crpt_size bytes) || ChaCha20 cipher text || Poly1305 tag
+// Every message has its own random session key, so the nonce is always zero.
+// The encrypted session key is authenticated as associated data
+//
+size_t get_hybrid_crypt_size(size_t);
+size_t get_hybrid_msg_size(size_t);
+
+// Session keys come from NPrng::get_rnd, which is implemented for WIN32 only, so
+// in other builds the function always fails
+bool hybrid_encrypt(const pub_key&, const uint8_t* msg, size_t len, uint8_t* out, size_t out_size);
+// Fails if the message is too short or was modified
+bool hybrid_decrypt(const CPrivKey&, const uint8_t* crpt, size_t len, uint8_t* out, size_t out_size);
+
+}
+
+#endif // HYBRID_H
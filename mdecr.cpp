@@ -0,0 +1,80 @@
+//***************************************************************************************
+// mdecr.cpp
+// Decryption with inverse matrices and inverse S-boxes (without tables)
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "mdecr.h"
+
+namespace NCrypt
+{
+
+CMatrixDecryption::CMatrixDecryption(const NCipher::CDecryption& d)
+{
+	for (int i = 0; i < bit_size; ++i)
+	{
+		memcpy(m_rows2[i], d.get_inv_bmtrx2()[i].get_internal_array(), sizeof(m_rows2[i]));
+		memcpy(m_rows1[i], d.get_inv_bmtrx1()[i].get_internal_array(), sizeof(m_rows1[i]));
+	}
+
+	memcpy(m_inv_substs, d.get_inv_comb_substs(), sizeof(m_inv_substs));
+}
+
+//
+// res = m * v, m has bit_size rows of Q qwords, res has bit_size bits
+//
+template <int Q>
+static void mul(const uint64_t (*m)[Q], const uint64_t* v, uint64_t* res)
+{
+	for (int i = 0; i < CMatrixDecryption::bit_size >> 6; ++i)
+		res[i] = 0;
+
+	for (int i = 0; i < CMatrixDecryption::bit_size; ++i)
+	{
+		uint64_t t(0);
+		for (int j = 0; j < Q; ++j)
+			t ^= m[i][j] & v[j];
+
+		res[i >> 6] |= get_parity(t) << (i & 63);
+	}
+}
+
+void CMatrixDecryption::decrypt(const uint8_t* crpt, uint8_t* msg) const
+{
+	uint64_t v2[row_qwords2];
+	uint64_t v1[row_qwords1];
+	uint64_t v0[row_qwords1];
+	uint8_t t[msg_size];
+
+	load_row<crpt_size>(v2, crpt);
+
+	// Multiply by inverse of the second matrix
+	mul<row_qwords2>(m_rows2, v2, v1);
+
+	// Multiply by inverse of the first matrix
+	mul<row_qwords1>(m_rows1, v1, v0);
+	store_row<msg_size>(t, v0);
+
+	// Inverse substitution
+	for (int i = 0; i < msg_size; ++i)
+		msg[i] = m_inv_substs[i][t[i]];
+}
+
+}
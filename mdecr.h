@@ -0,0 +1,64 @@
+//***************************************************************************************
+// mdecr.h
+// Decryption with inverse matrices and inverse S-boxes (without tables)
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "crypt.h"
+#include "tblrow.h"
+
+#ifndef MDECR_H
+#define MDECR_H
+
+namespace NCrypt
+{
+
+//
+// Decryption straight from the secret: every bit of a matrix-vector product is the parity
+// of a row ANDed with the vector. Only 256 rows of the inverse second matrix are needed
+// (the last 16 bits are mix bits), so the key takes 26 KB instead of 820 KB of tables
+//
+class CMatrixDecryption
+{
+public:
+	enum
+	{
+		bit_size = msg_size * 8,										// Number of rows of both matrices in use
+		row_qwords2 = TRow<crpt_size>::lanes,							// Row of the inverse second matrix (in qwords)
+		row_qwords1 = TRow<msg_size>::lanes								// Row of the inverse first matrix (in qwords)
+	};
+
+public:
+	CMatrixDecryption(const NCipher::CDecryption&);
+
+public:
+	// crpt_size bytes -> msg_size bytes
+	// Batches are decrypted with the same matrices by CBitslicedDecryption
+	void decrypt(const uint8_t*, uint8_t*) const;
+
+private:
+	uint64_t								m_rows2[bit_size][row_qwords2];
+	uint64_t								m_rows1[bit_size][row_qwords1];
+	NCipher::CDecryption::subst_arrays		m_inv_substs;
+};
+
+}
+
+#endif // MDECR_H
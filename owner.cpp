@@ -0,0 +1,101 @@
+//***************************************************************************************
+// owner.cpp
+// Fast encryption for the owner of a key:
+// nibble T-boxes and the mix are evaluated instead of combined public tables
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "owner.h"
+
+namespace NCrypt
+{
+
+typedef NBMatrix::TBMatrix<NCipher::CEncryption::bit_size2, NCipher::CEncryption::bit_size2> mix_mtrx;
+
+// out = m * in, in and out are crpt_size bytes
+static void mix(const mix_mtrx& m, const uint8_t* in, uint8_t* out)
+{
+	NBMatrix::TBArray<NCipher::CEncryption::bit_size2> b;
+	for (int j = 0; j < crpt_size; ++j)
+		((uint8_t*)b.get_internal_array())[j] = in[j];
+
+	b = m * b;
+
+	for (int j = 0; j < crpt_size; ++j)
+		out[j] = ((uint8_t*)b.get_internal_array())[j];
+}
+
+COwnerKey::COwnerKey(const NCipher::CEncryption& e)
+{
+	uint8_t t[crpt_size];
+
+	for (int i = 0; i < NCipher::CEncryption::sbsts_num; ++i)
+	{
+		for (int j = 0; j < NCipher::CEncryption::sbst_size; ++j)
+		{
+			// Mix bytes of T-boxes are not used
+			memset(t, 0, crpt_size);
+			memcpy(t, e.get_tbxs()[i][j], NCipher::CEncryption::tbox_clear_size);
+			mix(e.get_bmtrx2(), t, m_tbxs[i][j]);
+		}
+	}
+
+	for (int j = 0; j < NCipher::CEncryption::comb_sbst_size; ++j)
+	{
+		memset(t, 0, crpt_size);
+		t[crpt_size - 2] = (uint8_t)j;
+		mix(e.get_bmtrx2(), t, m_mix_tbxs[j]);
+	}
+
+	memset(t, 0, crpt_size);
+	for (int i = 0; i < NCipher::CEncryption::comb_sbsts_num; ++i)
+		t[crpt_size - 1] ^= e.get_high_mixes()[i];
+
+	mix(e.get_bmtrx2(), t, t);
+	load_row<crpt_size>(m_base, t);
+
+	memcpy(m_mixes, e.get_mixes(), sizeof(m_mixes));
+}
+
+void COwnerKey::encrypt(const uint8_t* msg, uint8_t* crpt) const
+{
+	uint64_t acc[TRow<crpt_size>::lanes];
+	memcpy(acc, m_base, sizeof(acc));
+
+	uint8_t l(0);
+	for (int i = 0; i < msg_size; ++i)
+	{
+		xor_row<crpt_size>(acc, m_tbxs[i << 1][msg[i] & 0x0f]);
+		xor_row<crpt_size>(acc, m_tbxs[(i << 1) + 1][msg[i] >> 4]);
+		l ^= m_mixes[i][msg[i]];
+	}
+
+	xor_row<crpt_size>(acc, m_mix_tbxs[l]);
+	store_row<crpt_size>(crpt, acc);
+}
+
+// Tables are small enough to stay in L1, so there is nothing to prefetch
+void COwnerKey::encrypt_batch(const uint8_t* msgs, size_t n, uint8_t* crpts) const
+{
+	for (size_t k = 0; k < n; ++k)
+		encrypt(msgs + k * msg_size, crpts + k * crpt_size);
+}
+
+}
@@ -0,0 +1,64 @@
+//***************************************************************************************
+// partial.cpp
+// Encryption of messages with fixed bytes
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+
+#include "partial.h"
+
+namespace NCrypt
+{
+
+CPartialKey::CPartialKey(const pub_key& key, uint32_t mask, const uint8_t* fixed) : m_key(key), m_mask(mask), m_vars_num(0)
+{
+	clear_row<crpt_size>(m_acc);
+
+	for (int i = 0; i < msg_size; ++i)
+	{
+		if (mask & (1u << i))
+			xor_row<crpt_size>(m_acc, key[i][fixed[i]]);
+		else
+			m_vars[m_vars_num++] = (uint8_t)i;
+	}
+}
+
+uint32_t CPartialKey::get_mask() const
+{
+	return m_mask;
+}
+
+void CPartialKey::encrypt(const uint8_t* msg, uint8_t* crpt) const
+{
+	uint64_t acc[TRow<crpt_size>::lanes];
+	memcpy(acc, m_acc, sizeof(acc));
+
+	for (int i = 0; i < m_vars_num; ++i)
+		xor_row<crpt_size>(acc, m_key[m_vars[i]][msg[m_vars[i]]]);
+
+	store_row<crpt_size>(crpt, acc);
+}
+
+void CPartialKey::encrypt_batch(const uint8_t* msgs, size_t n, uint8_t* crpts) const
+{
+	xor_rows_batch<crpt_size, batch_width>(m_key, CPositionList(m_vars, m_vars_num), m_acc, msgs, msg_size, n, crpts);
+}
+
+}
@@ -0,0 +1,64 @@
+//***************************************************************************************
+// partial.h
+// Encryption of messages with fixed bytes
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+
+#include "crypt.h"
+#include "tblrow.h"
+
+#ifndef PARTIAL_H
+#define PARTIAL_H
+
+namespace NCrypt
+{
+
+//
+// Encryption is XOR of rows selected by message bytes, so rows of bytes which
+// are the same in every message (a header, for example) are XORed only once
+//
+class CPartialKey
+{
+public:
+	// Bit i of the mask is set if byte i is fixed, fixed bytes are taken from msg_size bytes buffer
+	CPartialKey(const pub_key&, uint32_t mask, const uint8_t* fixed);
+
+private:
+	const CPartialKey& operator=(const CPartialKey&);
+
+public:
+	uint32_t get_mask() const;
+
+	// Messages are msg_size bytes long, their fixed bytes are ignored
+	void encrypt(const uint8_t*, uint8_t*) const;
+	void encrypt_batch(const uint8_t*, size_t, uint8_t*) const;
+
+private:
+	const pub_key&		m_key;
+	uint32_t			m_mask;
+	uint8_t				m_vars[msg_size];					// positions of variable bytes
+	int					m_vars_num;
+	uint64_t			m_acc[TRow<crpt_size>::lanes];		// XOR of rows of fixed bytes
+};
+
+}
+
+#endif // PARTIAL_H
@@ -22,6 +22,7 @@
 //***************************************************************************************
 
 #include "prng.h"
+#include "sha256.h"
 #include <iostream>
 
 #ifdef WIN32
@@ -173,55 +174,6 @@ public:
 		}
 	}
 
-	void sha2(void* buf, uint32_t size, void* hsh, uint32_t hsh_size)
-	{
-		if (!buf || !hsh)
-		{
-			printf("ERROR: SHA2 null input!!!\n");
-			exit(-1);
-		}
-
-		if (hsh_size != 32)
-		{
-			printf("ERROR: SHA2 size error!!!\n");
-			exit(-1);
-		}
-
-		HCRYPTHASH hHash = 0;
-		uint32_t obj_size = 32;
-		if (!CryptCreateHash(m_hCryptProv, CALG_SHA_256, 0, 0, &hHash))
-		{
-			DWORD err = ::GetLastError();
-			printf("ERROR: CryptCreateHash!!!\n");
-			exit(err);
-		}
-
-		BYTE *data = new BYTE[obj_size];
-
-		if (!CryptHashData(hHash, (PBYTE)buf, size, 0))
-		{
-			DWORD err = ::GetLastError();
-			printf("ERROR: CryptHashData!!!\n");
-			CryptDestroyHash(hHash);
-			delete[] data;
-			exit(err);
-		}
-
-		if (!CryptGetHashParam(hHash, HP_HASHVAL, data, (PDWORD)&obj_size, 0))
-		{
-			DWORD err = ::GetLastError();
-			printf("ERROR: CryptHashData!!!\n");
-			CryptDestroyHash(hHash);
-			delete[] data;
-			exit(err);
-		}
-
-		memcpy_s(hsh, hsh_size, data, obj_size);
-
-		CryptDestroyHash(hHash);
-		delete[] data;
-	}
-
 	~CWinSpecificPrngCtx()
 	{
 		if (m_hCryptProv)
@@ -272,13 +224,19 @@ uint8_t get_rnd_4()
 
 void sha2(void* buf, uint32_t size, void* hsh, uint32_t hsh_size)
 {
-#ifdef WIN32
-	g_win_prng_ctx.sha2(buf, size, hsh, hsh_size);
-#else
-	//
-	// TODO:
-	//
-#endif // WIN32
+	if (!buf || !hsh)
+	{
+		printf("ERROR: SHA2 null input!!!\n");
+		exit(-1);
+	}
+
+	if (hsh_size != NSha256::digest_size)
+	{
+		printf("ERROR: SHA2 size error!!!\n");
+		exit(-1);
+	}
+
+	NSha256::sha256(buf, size, (uint8_t*)hsh);
 }
 
 }
\ No newline at end of file
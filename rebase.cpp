@@ -0,0 +1,76 @@
+//***************************************************************************************
+// rebase.cpp
+// Rebased tables: row 0 of every table is folded into a constant,
+// so zero bytes of input cost nothing
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "rebase.h"
+
+namespace NCrypt
+{
+
+CRebasedPubKey::CRebasedPubKey(const pub_key& key) : m_tbls(key)
+{
+}
+
+void CRebasedPubKey::encrypt(const uint8_t* msg, uint8_t* crpt) const
+{
+	m_tbls.xor_tbls(msg, crpt);
+}
+
+void CRebasedPubKey::encrypt_batch(const uint8_t* msgs, size_t n, uint8_t* crpts) const
+{
+	m_tbls.xor_tbls_batch(msgs, msg_size, n, crpts);
+}
+
+CRebasedPrivKey::CRebasedPrivKey(const CPrivKey& key) : m_tbls2(key.get_inv_comb_tbxs2()), m_tbls1(key.get_inv_comb_tbxs1()),
+	m_tbls0(key.get_final_tbxs())
+{
+}
+
+void CRebasedPrivKey::decrypt(const uint8_t* crpt, uint8_t* msg) const
+{
+	uint8_t t0[crpt_size];
+	uint8_t t1[msg_size];
+
+	m_tbls2.xor_tbls(crpt, t0);
+	m_tbls1.xor_tbls(t0, t1);
+	m_tbls0.xor_tbls(t1, msg);
+}
+
+void CRebasedPrivKey::decrypt_batch(const uint8_t* crpts, size_t n, uint8_t* msgs) const
+{
+	enum { chunk = 16 * batch_width };
+
+	uint8_t t0[chunk * crpt_size];
+	uint8_t t1[chunk * msg_size];
+
+	for (size_t pos = 0; pos < n; pos += chunk)
+	{
+		size_t cnt = n - pos < chunk ? n - pos : chunk;
+
+		m_tbls2.xor_tbls_batch(crpts + pos * crpt_size, crpt_size, cnt, t0);
+		m_tbls1.xor_tbls_batch(t0, crpt_size, cnt, t1);
+		m_tbls0.xor_tbls_batch(t1, msg_size, cnt, msgs + pos * msg_size);
+	}
+}
+
+}
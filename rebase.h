@@ -0,0 +1,215 @@
+//***************************************************************************************
+// rebase.h
+// Rebased tables: row 0 of every table is folded into a constant,
+// so zero bytes of input cost nothing
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "crypt.h"
+#include "tblrow.h"
+
+#ifndef REBASE_H
+#define REBASE_H
+
+namespace NCrypt
+{
+
+//
+// tbls[i][b] = tbls[i][0] ^ (tbls[i][0] ^ tbls[i][b]), so XOR of rows is
+// base ^ XOR of rebased rows of non-zero bytes, where base = XOR of tbls[i][0]
+// Rebased row 0 is zero and is not stored
+//
+template <int IN, int OUT>
+class TRebasedTbls
+{
+public:
+	typedef uint8_t rebased_arrays[IN][255][OUT];
+
+public:
+	template <typename TBLS>
+	TRebasedTbls(const TBLS& tbls) : m_tbls(new rebased_arrays[1])
+	{
+		static_assert(IN >= 32 && IN < 64, "wrong input size");
+
+		clear_row<OUT>(m_base);
+
+		for (int i = 0; i < IN; ++i)
+		{
+			xor_row<OUT>(m_base, tbls[i][0]);
+
+			for (int b = 1; b < 256; ++b)
+			{
+				for (int j = 0; j < OUT; ++j)
+					m_tbls[0][i][b - 1][j] = tbls[i][b][j] ^ tbls[i][0][j];
+			}
+		}
+	}
+
+	~TRebasedTbls()
+	{
+		delete[] m_tbls;
+	}
+
+private:
+	TRebasedTbls(const TRebasedTbls&);
+	const TRebasedTbls& operator=(const TRebasedTbls&);
+
+public:
+	// out = XOR of tbls[i][in[i]] for i < IN
+	void xor_tbls(const uint8_t* in, uint8_t* out) const
+	{
+		uint8_t pos[IN];
+		xor_rows<OUT, 1>(get_rows(), CPositionList(pos, get_positions(in, pos)), m_base, in, 0, 1, out);
+	}
+
+	// The same for n inputs (IN bytes each, stride bytes apart), rows of the next
+	// batch_width inputs are prefetched while the current ones are accumulated
+	void xor_tbls_batch(const uint8_t* in, size_t stride, size_t n, uint8_t* out) const
+	{
+		// Non-zero positions of two groups of inputs
+		uint8_t pos[2][batch_width][IN];
+		int pos_num[2][batch_width];
+
+		size_t cnt = n < batch_width ? n : batch_width;
+		for (size_t k = 0; k < cnt; ++k)
+		{
+			pos_num[0][k] = get_positions(in + k * stride, pos[0][k]);
+			prefetch_rows<OUT>(get_rows(), CPositionList(pos[0][k], pos_num[0][k]), in + k * stride, 0, 1);
+		}
+
+		for (size_t p = 0; p < n; p += batch_width)
+		{
+			size_t cur = (p / batch_width) & 1;
+			size_t next = cur ^ 1;
+
+			cnt = n - p < batch_width ? n - p : batch_width;
+
+			for (size_t k = p + batch_width; k < n && k < p + 2 * batch_width; ++k)
+			{
+				size_t j = k - p - batch_width;
+				pos_num[next][j] = get_positions(in + k * stride, pos[next][j]);
+				prefetch_rows<OUT>(get_rows(), CPositionList(pos[next][j], pos_num[next][j]), in + k * stride, 0, 1);
+			}
+
+			// Inputs have different position lists, so they are accumulated one by one
+			for (size_t k = 0; k < cnt; ++k)
+			{
+				xor_rows<OUT, 1>(get_rows(), CPositionList(pos[cur][k], pos_num[cur][k]), m_base, in + (p + k) * stride, 0, 1,
+					out + (p + k) * OUT);
+			}
+		}
+	}
+
+private:
+	// Rebased rows of one input position, row b != 0 is stored at b - 1
+	struct SPosRows
+	{
+		const uint8_t	(*rows)[OUT];
+
+		const uint8_t* operator[](uint8_t b) const
+		{
+			return rows[b - 1];
+		}
+	};
+
+	// Rebased tables indexed as tbls[i][b]
+	struct SRows
+	{
+		const rebased_arrays	*tbls;
+
+		SPosRows operator[](int i) const
+		{
+			SPosRows r = { (*tbls)[i] };
+			return r;
+		}
+	};
+
+	SRows get_rows() const
+	{
+		SRows r = { m_tbls };
+		return r;
+	}
+
+	// Positions of non-zero bytes of the input, returns their number
+	static int get_positions(const uint8_t* in, uint8_t* pos)
+	{
+		uint64_t m = get_nonzero_mask32(in);
+		for (int i = 32; i < IN; ++i)
+			m |= (uint64_t)(in[i] != 0) << i;
+
+		int num = 0;
+		while (m)
+			pos[num++] = (uint8_t)pop_lowest_bit(m);
+
+		return num;
+	}
+
+private:
+	rebased_arrays	*m_tbls;
+	uint64_t		m_base[TRow<OUT>::lanes];
+};
+
+//
+// Public tables in the rebased form, the fewer non-zero bytes a message has the faster it is encrypted
+//
+class CRebasedPubKey
+{
+public:
+	CRebasedPubKey(const pub_key&);
+
+private:
+	CRebasedPubKey(const CRebasedPubKey&);
+	const CRebasedPubKey& operator=(const CRebasedPubKey&);
+
+public:
+	// msg_size bytes -> crpt_size bytes
+	void encrypt(const uint8_t*, uint8_t*) const;
+	void encrypt_batch(const uint8_t*, size_t, uint8_t*) const;
+
+private:
+	TRebasedTbls<msg_size, crpt_size>	m_tbls;
+};
+
+//
+// All three stages of private tables in the rebased form
+//
+class CRebasedPrivKey
+{
+public:
+	CRebasedPrivKey(const CPrivKey&);
+
+private:
+	CRebasedPrivKey(const CRebasedPrivKey&);
+	const CRebasedPrivKey& operator=(const CRebasedPrivKey&);
+
+public:
+	// crpt_size bytes -> msg_size bytes
+	void decrypt(const uint8_t*, uint8_t*) const;
+	void decrypt_batch(const uint8_t*, size_t, uint8_t*) const;
+
+private:
+	TRebasedTbls<crpt_size, crpt_size>	m_tbls2;
+	TRebasedTbls<msg_size, msg_size>	m_tbls1;
+	TRebasedTbls<msg_size, msg_size>	m_tbls0;
+};
+
+}
+
+#endif // REBASE_H
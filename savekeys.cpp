@@ -42,6 +42,10 @@ bool save_public_key(const char *filename, const NCipher::CEncryption &e)
 
 bool save_private_key(const char *filename, const NCipher::CDecryption &d)
 {
+	// Saved keys always have byte geometry
+	if (d.get_geometry() != NCipher::CDecryption::byte_geometry)
+		return false;
+
 	FILE *f;
 	errno_t err = fopen_s(&f, filename, "w+b");
 	if (err)
@@ -0,0 +1,644 @@
+//***************************************************************************************
+// sha256.cpp
+// SHA-256 (FIPS 180-4) with SHA-NI and 8-lane AVX2 implementations
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "sha256.h"
+#include "cpu.h"
+#include <string.h>
+
+// SHA-NI needs Visual Studio 2015, AVX2 is available since Visual Studio 2012 (see cpu.h)
+#if defined(WB_HAS_SHA) || defined(WB_HAS_AVX2)
+#include <immintrin.h>
+#endif // WB_HAS_SHA || WB_HAS_AVX2
+
+namespace NSha256
+{
+
+static const uint32_t k256[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t h256[8] =
+{
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static inline uint32_t rotr(uint32_t x, int n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t load_be32(const uint8_t* p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void store_be32(uint8_t* p, uint32_t v)
+{
+	p[0] = (uint8_t)(v >> 24);
+	p[1] = (uint8_t)(v >> 16);
+	p[2] = (uint8_t)(v >> 8);
+	p[3] = (uint8_t)v;
+}
+
+static inline uint32_t bsig0(uint32_t x)
+{
+	return rotr(x, 2) ^ rotr(x, 13) ^ rotr(x, 22);
+}
+
+static inline uint32_t bsig1(uint32_t x)
+{
+	return rotr(x, 6) ^ rotr(x, 11) ^ rotr(x, 25);
+}
+
+static inline uint32_t ssig0(uint32_t x)
+{
+	return rotr(x, 7) ^ rotr(x, 18) ^ (x >> 3);
+}
+
+static inline uint32_t ssig1(uint32_t x)
+{
+	return rotr(x, 17) ^ rotr(x, 19) ^ (x >> 10);
+}
+
+static inline uint32_t bswap32(uint32_t x)
+{
+	return (x >> 24) | ((x >> 8) & 0xff00) | ((x << 8) & 0xff0000) | (x << 24);
+}
+
+//
+// Rounds from..to - 1 over state s
+//
+static inline void do_rounds(uint32_t* s, const uint32_t* w, int from, int to)
+{
+	uint32_t a = s[0], b = s[1], c = s[2], d = s[3];
+	uint32_t e = s[4], f = s[5], g = s[6], h = s[7];
+
+	for (int t = from; t < to; ++t)
+	{
+		uint32_t t1 = h + bsig1(e) + ((e & f) ^ (~e & g)) + k256[t] + w[t];
+		uint32_t t2 = bsig0(a) + ((a & b) ^ (a & c) ^ (b & c));
+
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	s[0] = a;
+	s[1] = b;
+	s[2] = c;
+	s[3] = d;
+	s[4] = e;
+	s[5] = f;
+	s[6] = g;
+	s[7] = h;
+}
+
+static void compress_scalar(uint32_t* state, const uint8_t* blocks, size_t n)
+{
+	uint32_t w[64];
+
+	for (; n; --n, blocks += block_size)
+	{
+		for (int t = 0; t < 16; ++t)
+			w[t] = load_be32(blocks + (t << 2));
+
+		for (int t = 16; t < 64; ++t)
+			w[t] = w[t - 16] + ssig0(w[t - 15]) + w[t - 7] + ssig1(w[t - 2]);
+
+		uint32_t s[8];
+		memcpy(s, state, sizeof(s));
+		do_rounds(s, w, 0, 64);
+
+		for (int i = 0; i < 8; ++i)
+			state[i] += s[i];
+	}
+}
+
+#ifdef WB_HAS_SHA
+
+//
+// SHA-NI keeps the state as ABEF and CDGH, every instruction does two rounds
+//
+WB_TARGET("sha,sse4.1") static void compress_shani(uint32_t* state, const uint8_t* blocks, size_t n)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+
+	__m128i t = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0xb1);			// CDAB
+	__m128i s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(state + 4)), 0x1b);	// EFGH
+	__m128i s0 = _mm_alignr_epi8(t, s1, 8);												// ABEF
+	s1 = _mm_blend_epi16(s1, t, 0xf0);													// CDGH
+
+	for (; n; --n, blocks += block_size)
+	{
+		__m128i abef = s0;
+		__m128i cdgh = s1;
+		__m128i m[4];
+
+		for (int i = 0; i < 16; ++i)
+		{
+			__m128i& w = m[i & 3];
+
+			if (i < 4)
+			{
+				w = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + (i << 4))), mask);
+			}
+			else
+			{
+				// w[t] for 4 rounds from w[t - 16] .. w[t - 1]
+				__m128i w7 = _mm_alignr_epi8(m[(i - 1) & 3], m[(i - 2) & 3], 4);
+				w = _mm_sha256msg1_epu32(w, m[(i - 3) & 3]);
+				w = _mm_add_epi32(w, w7);
+				w = _mm_sha256msg2_epu32(w, m[(i - 1) & 3]);
+			}
+
+			__m128i wk = _mm_add_epi32(w, _mm_loadu_si128((const __m128i*)(k256 + (i << 2))));
+			s1 = _mm_sha256rnds2_epu32(s1, s0, wk);
+			s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(wk, 0x0e));
+		}
+
+		s0 = _mm_add_epi32(s0, abef);
+		s1 = _mm_add_epi32(s1, cdgh);
+	}
+
+	t = _mm_shuffle_epi32(s0, 0x1b);								// FEBA
+	s1 = _mm_shuffle_epi32(s1, 0xb1);								// DCHG
+	_mm_storeu_si128((__m128i*)state, _mm_blend_epi16(t, s1, 0xf0));		// DCBA
+	_mm_storeu_si128((__m128i*)(state + 4), _mm_alignr_epi8(s1, t, 8));	// ABEF
+}
+
+#endif // WB_HAS_SHA
+
+#ifdef WB_HAS_AVX2
+
+#define WB_ROTR8(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+//
+// 8 messages in lanes of 256-bit vectors, block i of message j is blocks[j] + i * block_size
+//
+WB_TARGET("avx2") static void compress_x8(__m256i* state, const uint8_t* const* blocks, size_t n)
+{
+	const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+	__m256i w[64];
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		size_t offs = i * block_size;
+
+		// Transpose: word t of all messages
+		for (int t = 0; t < 16; ++t)
+		{
+			__m256i v = _mm256_set_epi32(
+				*(const int*)(blocks[7] + offs + (t << 2)), *(const int*)(blocks[6] + offs + (t << 2)),
+				*(const int*)(blocks[5] + offs + (t << 2)), *(const int*)(blocks[4] + offs + (t << 2)),
+				*(const int*)(blocks[3] + offs + (t << 2)), *(const int*)(blocks[2] + offs + (t << 2)),
+				*(const int*)(blocks[1] + offs + (t << 2)), *(const int*)(blocks[0] + offs + (t << 2)));
+			w[t] = _mm256_shuffle_epi8(v, bswap);
+		}
+
+		for (int t = 16; t < 64; ++t)
+		{
+			__m256i s0 = _mm256_xor_si256(_mm256_xor_si256(WB_ROTR8(w[t - 15], 7), WB_ROTR8(w[t - 15], 18)), _mm256_srli_epi32(w[t - 15], 3));
+			__m256i s1 = _mm256_xor_si256(_mm256_xor_si256(WB_ROTR8(w[t - 2], 17), WB_ROTR8(w[t - 2], 19)), _mm256_srli_epi32(w[t - 2], 10));
+			w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], s0), _mm256_add_epi32(w[t - 7], s1));
+		}
+
+		__m256i a = state[0], b = state[1], c = state[2], d = state[3];
+		__m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+		for (int t = 0; t < 64; ++t)
+		{
+			__m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+			__m256i se = _mm256_xor_si256(_mm256_xor_si256(WB_ROTR8(e, 6), WB_ROTR8(e, 11)), WB_ROTR8(e, 25));
+			__m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, se), _mm256_add_epi32(ch, _mm256_add_epi32(w[t], _mm256_set1_epi32((int)k256[t]))));
+			__m256i maj = _mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_xor_si256(a, b)));
+			__m256i sa = _mm256_xor_si256(_mm256_xor_si256(WB_ROTR8(a, 2), WB_ROTR8(a, 13)), WB_ROTR8(a, 22));
+			__m256i t2 = _mm256_add_epi32(sa, maj);
+
+			h = g;
+			g = f;
+			f = e;
+			e = _mm256_add_epi32(d, t1);
+			d = c;
+			c = b;
+			b = a;
+			a = _mm256_add_epi32(t1, t2);
+		}
+
+		state[0] = _mm256_add_epi32(state[0], a);
+		state[1] = _mm256_add_epi32(state[1], b);
+		state[2] = _mm256_add_epi32(state[2], c);
+		state[3] = _mm256_add_epi32(state[3], d);
+		state[4] = _mm256_add_epi32(state[4], e);
+		state[5] = _mm256_add_epi32(state[5], f);
+		state[6] = _mm256_add_epi32(state[6], g);
+		state[7] = _mm256_add_epi32(state[7], h);
+	}
+}
+
+WB_TARGET("avx2") static inline __m256i ssig0_x8(__m256i x)
+{
+	return _mm256_xor_si256(_mm256_xor_si256(WB_ROTR8(x, 7), WB_ROTR8(x, 18)), _mm256_srli_epi32(x, 3));
+}
+
+WB_TARGET("avx2") static inline __m256i ssig1_x8(__m256i x)
+{
+	return _mm256_xor_si256(_mm256_xor_si256(WB_ROTR8(x, 17), WB_ROTR8(x, 19)), _mm256_srli_epi32(x, 10));
+}
+
+//
+// Words of CSuffixHash for suffix_hash_avx2: message block words, constant parts
+// of the schedule and the state after round 7
+//
+enum
+{
+	block_words,
+	const_words,
+	mid_words
+};
+
+// All lanes have the same prefix
+struct SBroadcast
+{
+	const uint32_t*		words[3];
+
+	WB_TARGET("avx2") __m256i get(int a, int i) const
+	{
+		return _mm256_set1_epi32((int)words[a][i]);
+	}
+};
+
+// Every lane has its own prefix
+struct SGather
+{
+	const uint32_t*		words[3][lanes_num];
+
+	WB_TARGET("avx2") __m256i get(int a, int i) const
+	{
+		const uint32_t* const* p = words[a];
+		return _mm256_set_epi32((int)p[7][i], (int)p[6][i], (int)p[5][i], (int)p[4][i], (int)p[3][i], (int)p[2][i], (int)p[1][i], (int)p[0][i]);
+	}
+};
+
+//
+// CSuffixHash::hash_x8 with suffixes in lanes, see CSuffixHash::hash
+//
+template <typename WORDS>
+WB_TARGET("avx2") static void suffix_hash_avx2(const WORDS& words, const uint64_t* suffixes, uint8_t* digests)
+{
+	uint32_t lo[lanes_num];
+	uint32_t hi[lanes_num];
+	for (int j = 0; j < lanes_num; ++j)
+	{
+		lo[j] = bswap32((uint32_t)suffixes[j]);
+		hi[j] = bswap32((uint32_t)(suffixes[j] >> 32));
+	}
+
+	__m256i w[64];
+	for (int t = 0; t < 16; ++t)
+	{
+		if (t != 8 && t != 9)
+			w[t] = words.get(block_words, t);
+	}
+
+	w[8] = _mm256_loadu_si256((const __m256i*)lo);
+	w[9] = _mm256_loadu_si256((const __m256i*)hi);
+
+	__m256i c[8];
+	for (int i = 0; i < 8; ++i)
+		c[i] = words.get(const_words, i);
+
+	w[16] = _mm256_add_epi32(c[0], w[9]);
+	w[17] = c[1];
+	w[18] = _mm256_add_epi32(c[2], ssig1_x8(w[16]));
+	w[19] = c[3];
+	w[20] = _mm256_add_epi32(c[4], ssig1_x8(w[18]));
+	w[21] = c[5];
+	w[22] = _mm256_add_epi32(c[6], ssig1_x8(w[20]));
+	w[23] = _mm256_add_epi32(_mm256_add_epi32(c[7], w[16]), ssig0_x8(w[8]));
+
+	for (int t = 24; t < 64; ++t)
+		w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], ssig0_x8(w[t - 15])), _mm256_add_epi32(w[t - 7], ssig1_x8(w[t - 2])));
+
+	__m256i a = words.get(mid_words, 0), b = words.get(mid_words, 1);
+	__m256i cc = words.get(mid_words, 2), d = words.get(mid_words, 3);
+	__m256i e = words.get(mid_words, 4), f = words.get(mid_words, 5);
+	__m256i g = words.get(mid_words, 6), h = words.get(mid_words, 7);
+
+	for (int t = 8; t < 64; ++t)
+	{
+		__m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+		__m256i se = _mm256_xor_si256(_mm256_xor_si256(WB_ROTR8(e, 6), WB_ROTR8(e, 11)), WB_ROTR8(e, 25));
+		__m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, se), _mm256_add_epi32(ch, _mm256_add_epi32(w[t], _mm256_set1_epi32((int)k256[t]))));
+		__m256i maj = _mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(cc, _mm256_xor_si256(a, b)));
+		__m256i sa = _mm256_xor_si256(_mm256_xor_si256(WB_ROTR8(a, 2), WB_ROTR8(a, 13)), WB_ROTR8(a, 22));
+		__m256i t2 = _mm256_add_epi32(sa, maj);
+
+		h = g;
+		g = f;
+		f = e;
+		e = _mm256_add_epi32(d, t1);
+		d = cc;
+		cc = b;
+		b = a;
+		a = _mm256_add_epi32(t1, t2);
+	}
+
+	__m256i state[8] = { a, b, cc, d, e, f, g, h };
+	uint32_t out[8][lanes_num];
+	for (int i = 0; i < 8; ++i)
+		_mm256_storeu_si256((__m256i*)out[i], _mm256_add_epi32(state[i], _mm256_set1_epi32((int)h256[i])));
+
+	for (int j = 0; j < lanes_num; ++j)
+	{
+		for (int i = 0; i < 8; ++i)
+			store_be32(digests + j * digest_size + (i << 2), out[i][j]);
+	}
+}
+
+#undef WB_ROTR8
+
+WB_TARGET("avx2") static void sha256_avx2(const uint8_t* const* msgs, size_t len, uint8_t* digests)
+{
+	__m256i state[8];
+	for (int i = 0; i < 8; ++i)
+		state[i] = _mm256_set1_epi32((int)h256[i]);
+
+	size_t full = len / block_size;
+	compress_x8(state, msgs, full);
+
+	// Padded tails of all messages (one or two blocks)
+	uint8_t tails[lanes_num][block_size * 2];
+	const uint8_t* ptails[lanes_num];
+
+	size_t rest = len - full * block_size;
+	size_t tail_blocks = rest + 9 > block_size ? 2 : 1;
+
+	for (int j = 0; j < lanes_num; ++j)
+	{
+		memset(tails[j], 0, sizeof(tails[j]));
+		memcpy(tails[j], msgs[j] + full * block_size, rest);
+		tails[j][rest] = 0x80;
+
+		uint64_t bits = (uint64_t)len << 3;
+		for (int i = 0; i < 8; ++i)
+			tails[j][tail_blocks * block_size - 1 - i] = (uint8_t)(bits >> (i << 3));
+
+		ptails[j] = tails[j];
+	}
+
+	compress_x8(state, ptails, tail_blocks);
+
+	uint32_t words[8][lanes_num];
+	for (int i = 0; i < 8; ++i)
+		_mm256_storeu_si256((__m256i*)words[i], state[i]);
+
+	for (int j = 0; j < lanes_num; ++j)
+	{
+		for (int i = 0; i < 8; ++i)
+			store_be32(digests + j * digest_size + (i << 2), words[i][j]);
+	}
+}
+
+#endif // WB_HAS_AVX2
+
+void init_state(uint32_t* state)
+{
+	memcpy(state, h256, sizeof(h256));
+}
+
+void compress(uint32_t* state, const uint8_t* blocks, size_t n)
+{
+#ifdef WB_HAS_SHA
+	static const bool shani = NCpu::has_sha() && NCpu::has_sse41();
+
+	if (shani)
+	{
+		compress_shani(state, blocks, n);
+		return;
+	}
+#endif // WB_HAS_SHA
+
+	compress_scalar(state, blocks, n);
+}
+
+CSha256::CSha256() : m_buf_len(0), m_len(0)
+{
+	init_state(m_state);
+}
+
+void CSha256::update(const void* data, size_t len)
+{
+	const uint8_t* p = (const uint8_t*)data;
+	m_len += len;
+
+	if (m_buf_len)
+	{
+		size_t t = block_size - m_buf_len;
+		if (t > len)
+			t = len;
+
+		memcpy(m_buf + m_buf_len, p, t);
+		m_buf_len += t;
+		p += t;
+		len -= t;
+
+		if (m_buf_len < block_size)
+			return;
+
+		compress(m_state, m_buf, 1);
+		m_buf_len = 0;
+	}
+
+	size_t n = len / block_size;
+	compress(m_state, p, n);
+	p += n * block_size;
+	len -= n * block_size;
+
+	memcpy(m_buf, p, len);
+	m_buf_len = len;
+}
+
+void CSha256::final(uint8_t* digest)
+{
+	uint64_t bits = m_len << 3;
+
+	m_buf[m_buf_len++] = 0x80;
+	if (m_buf_len > block_size - 8)
+	{
+		memset(m_buf + m_buf_len, 0, block_size - m_buf_len);
+		compress(m_state, m_buf, 1);
+		m_buf_len = 0;
+	}
+
+	memset(m_buf + m_buf_len, 0, block_size - 8 - m_buf_len);
+	for (int i = 0; i < 8; ++i)
+		m_buf[block_size - 1 - i] = (uint8_t)(bits >> (i << 3));
+
+	compress(m_state, m_buf, 1);
+
+	for (int i = 0; i < 8; ++i)
+		store_be32(digest + (i << 2), m_state[i]);
+}
+
+CSuffixHash::CSuffixHash(const uint8_t* prefix)
+{
+	uint8_t block[block_size];
+	memset(block, 0, sizeof(block));
+	memcpy(block, prefix, prefix_size);
+	block[msg_len] = 0x80;
+	block[block_size - 2] = (uint8_t)((msg_len << 3) >> 8);
+	block[block_size - 1] = (uint8_t)(msg_len << 3);
+
+	for (int t = 0; t < 16; ++t)
+		m_w[t] = load_be32(block + (t << 2));
+
+	const uint32_t* w = m_w;
+	uint32_t w17 = ssig1(w[15]) + w[10] + ssig0(w[2]) + w[1];
+	uint32_t w19 = ssig1(w17) + w[12] + ssig0(w[4]) + w[3];
+	uint32_t w21 = ssig1(w19) + w[14] + ssig0(w[6]) + w[5];
+
+	// Words 17, 19 and 21 do not depend on words 8 and 9 at all
+	m_c[0] = ssig1(w[14]) + ssig0(w[1]) + w[0];
+	m_c[1] = w17;
+	m_c[2] = w[11] + ssig0(w[3]) + w[2];
+	m_c[3] = w19;
+	m_c[4] = w[13] + ssig0(w[5]) + w[4];
+	m_c[5] = w21;
+	m_c[6] = w[15] + ssig0(w[7]) + w[6];
+	m_c[7] = ssig1(w21) + w[7];
+
+	init_state(m_mid);
+	do_rounds(m_mid, m_w, 0, 8);
+}
+
+void CSuffixHash::hash(uint64_t suffix, uint8_t* digest) const
+{
+	uint32_t w[64];
+	memcpy(w, m_w, sizeof(m_w));
+	w[8] = bswap32((uint32_t)suffix);
+	w[9] = bswap32((uint32_t)(suffix >> 32));
+
+	w[16] = m_c[0] + w[9];
+	w[17] = m_c[1];
+	w[18] = m_c[2] + ssig1(w[16]);
+	w[19] = m_c[3];
+	w[20] = m_c[4] + ssig1(w[18]);
+	w[21] = m_c[5];
+	w[22] = m_c[6] + ssig1(w[20]);
+	w[23] = m_c[7] + w[16] + ssig0(w[8]);
+
+	for (int t = 24; t < 64; ++t)
+		w[t] = w[t - 16] + ssig0(w[t - 15]) + w[t - 7] + ssig1(w[t - 2]);
+
+	uint32_t s[8];
+	memcpy(s, m_mid, sizeof(s));
+	do_rounds(s, w, 8, 64);
+
+	for (int i = 0; i < 8; ++i)
+		store_be32(digest + (i << 2), s[i] + h256[i]);
+}
+
+void CSuffixHash::hash_x8(uint64_t first, uint8_t* digests) const
+{
+	uint64_t suffixes[lanes_num];
+	for (int j = 0; j < lanes_num; ++j)
+		suffixes[j] = first + j;
+
+#ifdef WB_HAS_AVX2
+	static const bool avx2 = NCpu::has_avx2();
+
+	if (avx2)
+	{
+		SBroadcast words = { { m_w, m_c, m_mid } };
+		suffix_hash_avx2(words, suffixes, digests);
+		return;
+	}
+#endif // WB_HAS_AVX2
+
+	for (int j = 0; j < lanes_num; ++j)
+		hash(suffixes[j], digests + j * digest_size);
+}
+
+void CSuffixHash::hash_x8(const CSuffixHash* const* hashes, const uint64_t* suffixes, uint8_t* digests)
+{
+#ifdef WB_HAS_AVX2
+	static const bool avx2 = NCpu::has_avx2();
+
+	if (avx2)
+	{
+		SGather words;
+		for (int j = 0; j < lanes_num; ++j)
+		{
+			words.words[block_words][j] = hashes[j]->m_w;
+			words.words[const_words][j] = hashes[j]->m_c;
+			words.words[mid_words][j] = hashes[j]->m_mid;
+		}
+
+		suffix_hash_avx2(words, suffixes, digests);
+		return;
+	}
+#endif // WB_HAS_AVX2
+
+	for (int j = 0; j < lanes_num; ++j)
+		hashes[j]->hash(suffixes[j], digests + j * digest_size);
+}
+
+void sha256(const void* data, size_t len, uint8_t* digest)
+{
+	CSha256 h;
+	h.update(data, len);
+	h.final(digest);
+}
+
+void sha256_x8(const uint8_t* const* msgs, size_t len, uint8_t* digests)
+{
+#ifdef WB_HAS_AVX2
+	static const bool avx2 = NCpu::has_avx2();
+
+	if (avx2)
+	{
+		sha256_avx2(msgs, len, digests);
+		return;
+	}
+#endif // WB_HAS_AVX2
+
+	for (int j = 0; j < lanes_num; ++j)
+		sha256(msgs[j], len, digests + j * digest_size);
+}
+
+}
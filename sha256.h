@@ -0,0 +1,103 @@
+//***************************************************************************************
+// sha256.h
+// SHA-256 (FIPS 180-4) with SHA-NI and 8-lane AVX2 implementations
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef SHA256_H
+#define SHA256_H
+
+namespace NSha256
+{
+
+enum
+{
+	digest_size = 32,
+	block_size = 64,
+	lanes_num = 8							// Number of messages hashed at once by sha256_x8
+};
+
+//
+// Hash of a message given by parts
+//
+class CSha256
+{
+public:
+	CSha256();
+
+public:
+	void update(const void*, size_t);
+	void final(uint8_t*);					// digest_size bytes
+
+private:
+	uint32_t	m_state[8];
+	uint8_t		m_buf[block_size];
+	size_t		m_buf_len;
+	uint64_t	m_len;
+};
+
+//
+// Hashes of one block messages: a fixed prefix (digest_size bytes) followed by a 64-bit suffix
+// (little-endian). Rounds 0..7 depend only on the prefix and are done once, as well as the parts
+// of the message schedule which do not depend on the suffix
+//
+class CSuffixHash
+{
+public:
+	enum
+	{
+		prefix_size = digest_size,
+		msg_len = prefix_size + sizeof(uint64_t)
+	};
+
+public:
+	explicit CSuffixHash(const uint8_t* prefix);
+
+public:
+	void hash(uint64_t suffix, uint8_t* digest) const;
+	// Suffixes first .. first + lanes_num - 1 -> lanes_num digests
+	void hash_x8(uint64_t first, uint8_t* digests) const;
+	// Lane j hashes suffixes[j] with the prefix of hashes[j]
+	static void hash_x8(const CSuffixHash* const* hashes, const uint64_t* suffixes, uint8_t* digests);
+
+private:
+	uint32_t	m_w[16];				// message block words, words 8 and 9 hold the suffix
+	uint32_t	m_c[8];					// constant parts of words 16..23 of the schedule
+	uint32_t	m_mid[8];				// state after round 7
+};
+
+// Initial hash value
+void init_state(uint32_t*);
+// Process n blocks with the fastest implementation (SHA-NI or portable code)
+// SHA-NI is compiled with GCC, Clang or Visual Studio 2015 and later
+void compress(uint32_t* state, const uint8_t* blocks, size_t n);
+
+void sha256(const void*, size_t, uint8_t*);
+
+// lanes_num messages of the same length -> lanes_num digests (lanes_num * digest_size bytes)
+// AVX2 hashes all messages at once, otherwise they are hashed one by one
+void sha256_x8(const uint8_t* const* msgs, size_t len, uint8_t* digests);
+
+}
+
+#endif // SHA256_H
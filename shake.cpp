@@ -0,0 +1,202 @@
+//***************************************************************************************
+// shake.cpp
+// SHAKE256 extendable-output function (FIPS 202)
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "shake.h"
+#include <string.h>
+
+namespace NShake
+{
+
+static const uint64_t round_consts[24] =
+{
+	0x0000000000000001ull, 0x0000000000008082ull, 0x800000000000808aull, 0x8000000080008000ull,
+	0x000000000000808bull, 0x0000000080000001ull, 0x8000000080008081ull, 0x8000000000008009ull,
+	0x000000000000008aull, 0x0000000000000088ull, 0x0000000080008009ull, 0x000000008000000aull,
+	0x000000008000808bull, 0x800000000000008bull, 0x8000000000008089ull, 0x8000000000008003ull,
+	0x8000000000008002ull, 0x8000000000000080ull, 0x000000000000800aull, 0x800000008000000aull,
+	0x8000000080008081ull, 0x8000000000008080ull, 0x0000000080000001ull, 0x8000000080008008ull
+};
+
+static inline uint64_t rotl(uint64_t x, int n)
+{
+	return (x << n) | (x >> (64 - n));
+}
+
+//
+// Steps are written out lane by lane, loops over 5 lanes with indexes mod 5 are several times slower
+//
+void keccak_f1600(uint64_t* a)
+{
+	uint64_t a00 = a[0], a01 = a[1], a02 = a[2], a03 = a[3], a04 = a[4];
+	uint64_t a05 = a[5], a06 = a[6], a07 = a[7], a08 = a[8], a09 = a[9];
+	uint64_t a10 = a[10], a11 = a[11], a12 = a[12], a13 = a[13], a14 = a[14];
+	uint64_t a15 = a[15], a16 = a[16], a17 = a[17], a18 = a[18], a19 = a[19];
+	uint64_t a20 = a[20], a21 = a[21], a22 = a[22], a23 = a[23], a24 = a[24];
+
+	for (int r = 0; r < 24; ++r)
+	{
+		// Theta
+		uint64_t c0 = a00 ^ a05 ^ a10 ^ a15 ^ a20;
+		uint64_t c1 = a01 ^ a06 ^ a11 ^ a16 ^ a21;
+		uint64_t c2 = a02 ^ a07 ^ a12 ^ a17 ^ a22;
+		uint64_t c3 = a03 ^ a08 ^ a13 ^ a18 ^ a23;
+		uint64_t c4 = a04 ^ a09 ^ a14 ^ a19 ^ a24;
+
+		uint64_t d0 = c4 ^ rotl(c1, 1);
+		uint64_t d1 = c0 ^ rotl(c2, 1);
+		uint64_t d2 = c1 ^ rotl(c3, 1);
+		uint64_t d3 = c2 ^ rotl(c4, 1);
+		uint64_t d4 = c3 ^ rotl(c0, 1);
+
+		// Rho and pi: b[y][2x + 3y] = rotl(a[x][y] ^ d[x])
+		uint64_t b00 = a00 ^ d0;
+		uint64_t b01 = rotl(a06 ^ d1, 44);
+		uint64_t b02 = rotl(a12 ^ d2, 43);
+		uint64_t b03 = rotl(a18 ^ d3, 21);
+		uint64_t b04 = rotl(a24 ^ d4, 14);
+		uint64_t b05 = rotl(a03 ^ d3, 28);
+		uint64_t b06 = rotl(a09 ^ d4, 20);
+		uint64_t b07 = rotl(a10 ^ d0, 3);
+		uint64_t b08 = rotl(a16 ^ d1, 45);
+		uint64_t b09 = rotl(a22 ^ d2, 61);
+		uint64_t b10 = rotl(a01 ^ d1, 1);
+		uint64_t b11 = rotl(a07 ^ d2, 6);
+		uint64_t b12 = rotl(a13 ^ d3, 25);
+		uint64_t b13 = rotl(a19 ^ d4, 8);
+		uint64_t b14 = rotl(a20 ^ d0, 18);
+		uint64_t b15 = rotl(a04 ^ d4, 27);
+		uint64_t b16 = rotl(a05 ^ d0, 36);
+		uint64_t b17 = rotl(a11 ^ d1, 10);
+		uint64_t b18 = rotl(a17 ^ d2, 15);
+		uint64_t b19 = rotl(a23 ^ d3, 56);
+		uint64_t b20 = rotl(a02 ^ d2, 62);
+		uint64_t b21 = rotl(a08 ^ d3, 55);
+		uint64_t b22 = rotl(a14 ^ d4, 39);
+		uint64_t b23 = rotl(a15 ^ d0, 41);
+		uint64_t b24 = rotl(a21 ^ d1, 2);
+
+		// Chi and iota
+		a00 = b00 ^ (~b01 & b02) ^ round_consts[r];
+		a01 = b01 ^ (~b02 & b03);
+		a02 = b02 ^ (~b03 & b04);
+		a03 = b03 ^ (~b04 & b00);
+		a04 = b04 ^ (~b00 & b01);
+		a05 = b05 ^ (~b06 & b07);
+		a06 = b06 ^ (~b07 & b08);
+		a07 = b07 ^ (~b08 & b09);
+		a08 = b08 ^ (~b09 & b05);
+		a09 = b09 ^ (~b05 & b06);
+		a10 = b10 ^ (~b11 & b12);
+		a11 = b11 ^ (~b12 & b13);
+		a12 = b12 ^ (~b13 & b14);
+		a13 = b13 ^ (~b14 & b10);
+		a14 = b14 ^ (~b10 & b11);
+		a15 = b15 ^ (~b16 & b17);
+		a16 = b16 ^ (~b17 & b18);
+		a17 = b17 ^ (~b18 & b19);
+		a18 = b18 ^ (~b19 & b15);
+		a19 = b19 ^ (~b15 & b16);
+		a20 = b20 ^ (~b21 & b22);
+		a21 = b21 ^ (~b22 & b23);
+		a22 = b22 ^ (~b23 & b24);
+		a23 = b23 ^ (~b24 & b20);
+		a24 = b24 ^ (~b20 & b21);
+	}
+
+	a[0] = a00; a[1] = a01; a[2] = a02; a[3] = a03; a[4] = a04;
+	a[5] = a05; a[6] = a06; a[7] = a07; a[8] = a08; a[9] = a09;
+	a[10] = a10; a[11] = a11; a[12] = a12; a[13] = a13; a[14] = a14;
+	a[15] = a15; a[16] = a16; a[17] = a17; a[18] = a18; a[19] = a19;
+	a[20] = a20; a[21] = a21; a[22] = a22; a[23] = a23; a[24] = a24;
+}
+
+CShake256::CShake256() : m_pos(0), m_squeezing(false)
+{
+	memset(m_state, 0, sizeof(m_state));
+}
+
+//
+// Lanes are little-endian, so the state is accessed as bytes
+//
+void CShake256::update(const void* data, size_t len)
+{
+	const uint8_t* p = (const uint8_t*)data;
+	uint8_t* st = (uint8_t*)m_state;
+
+	while (len)
+	{
+		size_t n = rate - m_pos < len ? rate - m_pos : len;
+		for (size_t i = 0; i < n; ++i)
+			st[m_pos + i] ^= p[i];
+
+		m_pos += n;
+		p += n;
+		len -= n;
+
+		if (m_pos == rate)
+		{
+			keccak_f1600(m_state);
+			m_pos = 0;
+		}
+	}
+}
+
+void CShake256::squeeze(uint8_t* out, size_t len)
+{
+	uint8_t* st = (uint8_t*)m_state;
+
+	if (!m_squeezing)
+	{
+		// Domain separation bits of SHAKE and the padding
+		st[m_pos] ^= 0x1f;
+		st[rate - 1] ^= 0x80;
+		keccak_f1600(m_state);
+		m_pos = 0;
+		m_squeezing = true;
+	}
+
+	while (len)
+	{
+		if (m_pos == rate)
+		{
+			keccak_f1600(m_state);
+			m_pos = 0;
+		}
+
+		size_t n = rate - m_pos < len ? rate - m_pos : len;
+		memcpy(out, st + m_pos, n);
+
+		m_pos += n;
+		out += n;
+		len -= n;
+	}
+}
+
+void shake256(const void* in, size_t len, uint8_t* out, size_t out_len)
+{
+	CShake256 h;
+	h.update(in, len);
+	h.squeeze(out, out_len);
+}
+
+}
@@ -0,0 +1,63 @@
+//***************************************************************************************
+// shake.h
+// SHAKE256 extendable-output function (FIPS 202)
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef SHAKE_H
+#define SHAKE_H
+
+namespace NShake
+{
+
+enum
+{
+	rate = 136								// Bytes absorbed or squeezed per permutation
+};
+
+void keccak_f1600(uint64_t*);
+
+//
+// Input is absorbed with update, then any number of output bytes is squeezed.
+// update must not be called after squeeze
+//
+class CShake256
+{
+public:
+	CShake256();
+
+public:
+	void update(const void*, size_t);
+	void squeeze(uint8_t*, size_t);
+
+private:
+	uint64_t	m_state[25];
+	size_t		m_pos;							// position in the current block
+	bool		m_squeezing;
+};
+
+void shake256(const void* in, size_t len, uint8_t* out, size_t out_len);
+
+}
+
+#endif // SHAKE_H
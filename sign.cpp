@@ -0,0 +1,1086 @@
+//***************************************************************************************
+// sign.cpp
+// Digital signature: search of a counter giving a hash which is a valid cipher text
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "sign.h"
+#include "tblrow.h"
+#include "sha256.h"
+#include "shake.h"
+#include <string.h>
+#include <memory>
+
+namespace NSign
+{
+
+static void set_counter(std::vector<uint8_t>& buf, uint64_t counter, int counter_size)
+{
+	size_t len = buf.size() - counter_size;
+	for (int i = 0; i < counter_size; ++i)
+		buf[len + i] = (uint8_t)(counter >> (i << 3));
+}
+
+static std::vector<uint8_t> get_buf(const uint8_t* msg, size_t len, int counter_size)
+{
+	std::vector<uint8_t> buf(len + counter_size);
+	if (len)
+		memcpy(&buf[0], msg, len);
+
+	return buf;
+}
+
+static bool is_valid_counter_size(int counter_size)
+{
+	return counter_size > 0 && counter_size <= max_counter_size;
+}
+
+// The last counter of 8 bytes is never used, so the number always fits
+static uint64_t get_counters_num(int counter_size)
+{
+	return counter_size < max_counter_size ? (uint64_t)1 << (counter_size << 3) : ~(uint64_t)0;
+}
+
+static bool is_valid_counter(const SSignature& sig)
+{
+	return is_valid_counter_size(sig.counter_size) && sig.counter < get_counters_num(sig.counter_size);
+}
+
+//
+// Hashers give candidates of group positions at once, a position is
+// counter * per_counter + index of the candidate of the counter
+//
+
+//
+// Candidates of lanes_num counters at once for a short message,
+// every buf is the message followed by counter_size bytes of the counter
+//
+class CMsgHasher
+{
+public:
+	enum
+	{
+		group = NSha256::lanes_num,
+		per_counter = 1
+	};
+
+public:
+	CMsgHasher(const uint8_t* msg, size_t len, int counter_size) : m_counter_size(counter_size)
+	{
+		for (int j = 0; j < NSha256::lanes_num; ++j)
+			m_bufs[j] = get_buf(msg, len, counter_size);
+	}
+
+	int get_counter_size() const
+	{
+		return m_counter_size;
+	}
+
+	void operator()(uint64_t pos, uint8_t (*cands)[NCrypt::crpt_size])
+	{
+		const uint8_t* msgs[NSha256::lanes_num];
+		uint8_t digests[NSha256::lanes_num][NSha256::digest_size];
+
+		for (int j = 0; j < NSha256::lanes_num; ++j)
+		{
+			set_counter(m_bufs[j], pos + j, m_counter_size);
+			msgs[j] = &m_bufs[j][0];
+		}
+
+		NSha256::sha256_x8(msgs, m_bufs[0].size(), digests[0]);
+		set_candidates(digests, cands);
+	}
+
+	static void set_candidates(const uint8_t (*digests)[NSha256::digest_size], uint8_t (*cands)[NCrypt::crpt_size])
+	{
+		for (int j = 0; j < NSha256::lanes_num; ++j)
+		{
+			memset(cands[j], 0, NCrypt::crpt_size);
+			memcpy(cands[j], digests[j], NSha256::digest_size);
+		}
+	}
+
+private:
+	std::vector<uint8_t>	m_bufs[NSha256::lanes_num];
+	int						m_counter_size;
+};
+
+//
+// Candidates of lanes_num counters at once for a document digest
+//
+class CDocHasher
+{
+public:
+	enum
+	{
+		group = NSha256::lanes_num,
+		per_counter = 1
+	};
+
+public:
+	explicit CDocHasher(const uint8_t* digest) : m_hash(digest)
+	{
+	}
+
+	int get_counter_size() const
+	{
+		return max_counter_size;
+	}
+
+	void operator()(uint64_t pos, uint8_t (*cands)[NCrypt::crpt_size])
+	{
+		uint8_t digests[NSha256::lanes_num][NSha256::digest_size];
+
+		m_hash.hash_x8(pos, digests[0]);
+		CMsgHasher::set_candidates(digests, cands);
+	}
+
+private:
+	NSha256::CSuffixHash	m_hash;
+};
+
+//
+// All candidates of a counter from one permutation of SHAKE256
+//
+class CXofHasher
+{
+public:
+	enum
+	{
+		group = xof_cands_num,
+		per_counter = xof_cands_num
+	};
+
+public:
+	CXofHasher(const uint8_t* msg, size_t len, int counter_size) : m_buf(get_buf(msg, len, counter_size)), m_counter_size(counter_size)
+	{
+	}
+
+	int get_counter_size() const
+	{
+		return m_counter_size;
+	}
+
+	void operator()(uint64_t pos, uint8_t (*cands)[NCrypt::crpt_size])
+	{
+		set_counter(m_buf, pos / per_counter, m_counter_size);
+		NShake::shake256(&m_buf[0], m_buf.size(), cands[0], sizeof(cands[0]) * xof_cands_num);
+	}
+
+private:
+	std::vector<uint8_t>	m_buf;
+	int						m_counter_size;
+};
+
+void get_candidate(const uint8_t* msg, size_t len, uint64_t counter, uint8_t* cand, int counter_size)
+{
+	std::vector<uint8_t> buf(get_buf(msg, len, counter_size));
+	set_counter(buf, counter, counter_size);
+
+	memset(cand, 0, NCrypt::crpt_size);
+	NSha256::sha256(&buf[0], buf.size(), cand);
+}
+
+void get_xof_candidates(const uint8_t* msg, size_t len, uint64_t counter, uint8_t* cands, int counter_size)
+{
+	std::vector<uint8_t> buf(get_buf(msg, len, counter_size));
+	set_counter(buf, counter, counter_size);
+
+	NShake::shake256(&buf[0], buf.size(), cands, xof_cands_num * NCrypt::crpt_size);
+}
+
+void get_document_candidate(const uint8_t* data, size_t len, uint64_t counter, uint8_t* cand)
+{
+	uint8_t digest[NSha256::digest_size];
+	NSha256::sha256(data, len, digest);
+
+	memset(cand, 0, NCrypt::crpt_size);
+	NSha256::CSuffixHash(digest).hash(counter, cand);
+}
+
+CSignKey::CSignKey(const NCrypt::CPrivKey& priv, const NCrypt::pub_key& pub) : m_priv(priv), m_pub(&pub), m_high_mix(0)
+{
+	NCipher::gen_check_tbxs(m_check_tbxs, priv.get_inv_comb_tbxs2());
+	m_high_mix = NCipher::gen_mixes(m_mixes, pub, m_check_tbxs);
+}
+
+const NCrypt::CPrivKey& CSignKey::get_priv() const
+{
+	return m_priv;
+}
+
+const NCrypt::pub_key& CSignKey::get_pub() const
+{
+	return *m_pub;
+}
+
+bool CSignKey::try_candidate(const uint8_t* cand, uint8_t* body) const
+{
+	// Mix bytes after the inverse second matrix (255 of 256 candidates are rejected here)
+	uint16_t mix(0);
+	for (int i = 0; i < NCrypt::crpt_size; ++i)
+		mix ^= m_check_tbxs[i][cand[i]];
+
+	if ((uint8_t)(mix >> 8) != m_high_mix)
+		return false;
+
+	NCrypt::decrypt(m_priv, cand, body);
+
+	uint8_t low_mix(0);
+	for (int i = 0; i < NCrypt::msg_size; ++i)
+		low_mix ^= m_mixes[i][body[i]];
+
+	if (low_mix != (uint8_t)mix)
+		return false;
+
+	// Both mix bytes are right, so re-encryption must give the candidate back
+	// unless keys do not match. It is checked lane by lane
+	typedef NCrypt::TRow<NCrypt::crpt_size> row;
+
+	for (int q = 0; q < row::lanes; ++q)
+	{
+		int size = q < row::full_lanes ? 8 : row::tail;
+		uint64_t acc(0);
+		uint64_t t(0);
+
+		for (int i = 0; i < NCrypt::msg_size; ++i)
+		{
+			memcpy(&t, (*m_pub)[i][body[i]] + (q << 3), size);
+			acc ^= t;
+		}
+
+		t = 0;
+		memcpy(&t, cand + (q << 3), size);
+		if (acc != t)
+			return false;
+	}
+
+	return true;
+}
+
+bool sign(const NCrypt::CPrivKey& priv, const NCrypt::pub_key& pub, const uint8_t* msg, size_t len, SSignature& sig,
+	NExec::CExecutor& exec, bool deterministic, int counter_size, SSignStats* stats)
+{
+	CSignKey key(priv, pub);
+
+	return sign(key, msg, len, sig, exec, deterministic, counter_size, stats);
+}
+
+CCancelToken::CCancelToken() : m_cancelled(false)
+{
+}
+
+void CCancelToken::cancel()
+{
+	m_cancelled.store(true);
+}
+
+bool CCancelToken::is_cancelled() const
+{
+	return m_cancelled.load(std::memory_order_relaxed);
+}
+
+SSignLimits::SSignLimits() : max_attempts(0), deadline(std::chrono::steady_clock::time_point::max()), cancel(nullptr)
+{
+}
+
+SSignStats::SSignStats() : attempts(0), elapsed(0)
+{
+}
+
+static std::atomic<uint64_t> g_histogram[histogram_size];
+
+static int get_log2(uint64_t v)
+{
+	int r = 0;
+	while (v >>= 1)
+		++r;
+
+	return r;
+}
+
+void get_attempts_histogram(uint64_t* counts)
+{
+	for (int i = 0; i < histogram_size; ++i)
+		counts[i] = g_histogram[i].load();
+}
+
+void reset_attempts_histogram()
+{
+	for (int i = 0; i < histogram_size; ++i)
+		g_histogram[i].store(0);
+}
+
+//
+// State of a search of the lowest valid position. Every chunk of the search takes ranges
+// of positions in increasing order with its own copy of the hasher until the search is over,
+// limits are checked before every range. A chunk which starts after that returns at once
+// and does not touch the key or the limits
+//
+template <typename HASHER>
+class TSearch
+{
+public:
+	TSearch(const CSignKey& key, const HASHER& hasher, bool deterministic, const SSignLimits& limits) :
+		m_key(key), m_hasher(hasher), m_deterministic(deterministic), m_limits(limits), m_start(std::chrono::steady_clock::now()),
+		m_next(0), m_stop(false), m_over(false), m_status(sign_exhausted), m_attempts(0)
+	{
+		const uint64_t max_counters = ~(uint64_t)0 / HASHER::per_counter;
+		const uint64_t counters_num = get_counters_num(hasher.get_counter_size());
+
+		m_positions_num = (counters_num < max_counters ? counters_num : max_counters) * HASHER::per_counter;
+		m_limit = limits.max_attempts && limits.max_attempts < m_positions_num ? limits.max_attempts : m_positions_num;
+		m_best = m_positions_num;
+	}
+
+private:
+	TSearch(const TSearch&);
+	const TSearch& operator=(const TSearch&);
+
+public:
+	// A chunk, an exception stops the search and is thrown by finish
+	void run()
+	{
+		try
+		{
+			search();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			if (!m_error)
+				m_error = std::current_exception();
+			m_stop.store(true);
+		}
+	}
+
+	// Called once when no chunk is running
+	sign_status finish(SSignature& sig, SSignStats* stats)
+	{
+		if (m_error)
+			std::rethrow_exception(m_error);
+
+		sign_status res = m_best.load() < m_positions_num ? sign_done : (sign_status)m_status.load();
+
+		if (res == sign_done)
+		{
+			sig = m_sig;
+			++g_histogram[get_log2(m_attempts.load())];
+		}
+
+		if (stats)
+		{
+			stats->attempts = m_attempts.load();
+			stats->elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+		}
+
+		return res;
+	}
+
+private:
+	void search()
+	{
+		HASHER hash(m_hasher);
+		uint8_t cands[HASHER::group][NCrypt::crpt_size];
+		uint8_t body[NCrypt::msg_size];
+		uint64_t tried(0);
+
+		while (!m_stop.load(std::memory_order_relaxed) && !m_over.load())
+		{
+			if (m_limits.cancel && m_limits.cancel->is_cancelled())
+			{
+				m_status.store(sign_cancelled);
+				m_stop.store(true);
+				break;
+			}
+
+			if (m_limits.deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= m_limits.deadline)
+			{
+				m_status.store(sign_timeout);
+				m_stop.store(true);
+				break;
+			}
+
+			uint64_t begin = m_next.fetch_add(sign_grain);
+			if (begin >= m_best.load())
+				break;
+
+			if (begin >= m_limit)
+			{
+				if (m_limit < m_positions_num)
+					m_status.store(sign_over_budget);
+				break;
+			}
+
+			uint64_t end = begin + sign_grain < m_limit ? begin + sign_grain : m_limit;
+			for (uint64_t c = begin; c < end && !m_stop.load(std::memory_order_relaxed); ++c)
+			{
+				// sign_grain is a multiple of group, so a group never crosses the range
+				if (!((c - begin) % HASHER::group))
+					hash(c, cands);
+
+				++tried;
+
+				if (!m_key.try_candidate(cands[(c - begin) % HASHER::group], body))
+					continue;
+
+				std::lock_guard<std::mutex> lock(m_mtx);
+				if (c < m_best.load())
+				{
+					m_best.store(c);
+					m_sig.counter = c / HASHER::per_counter;
+					m_sig.counter_size = (uint8_t)m_hasher.get_counter_size();
+					m_sig.index = (uint8_t)(c % HASHER::per_counter);
+					memcpy(m_sig.body, body, sizeof(body));
+				}
+
+				if (!m_deterministic)
+					m_stop.store(true);
+
+				break;
+			}
+		}
+
+		// Ranges which are not taken are above the result or the limit. A chunk in a range
+		// finishes it, so the lowest valid position is found anyway
+		m_over.store(true);
+		m_attempts += tried;
+	}
+
+private:
+	const CSignKey&							m_key;
+	const HASHER							m_hasher;
+	const bool								m_deterministic;
+	const SSignLimits						m_limits;
+	std::chrono::steady_clock::time_point	m_start;
+	uint64_t								m_positions_num;
+	uint64_t								m_limit;
+	std::atomic<uint64_t>					m_next;
+	std::atomic<uint64_t>					m_best;			// the lowest valid position found
+	std::atomic<bool>						m_stop;
+	std::atomic<bool>						m_over;			// a chunk has left the search
+	std::atomic<int>						m_status;		// why the search was stopped if nothing is found
+	std::atomic<uint64_t>					m_attempts;
+	std::mutex								m_mtx;
+	SSignature								m_sig;
+	std::exception_ptr						m_error;
+};
+
+template <typename HASHER>
+static sign_status search(const CSignKey& key, const HASHER& hasher, SSignature& sig, NExec::CExecutor& exec, bool deterministic,
+	const SSignLimits& limits = SSignLimits(), SSignStats* stats = nullptr)
+{
+	TSearch<HASHER> s(key, hasher, deterministic, limits);
+
+	// Every worker and the caller run a chunk
+	exec.parallel_for(exec.get_threads_num() + 1, 1, [&s](size_t, size_t)
+	{
+		s.run();
+	});
+
+	return s.finish(sig, stats);
+}
+
+//
+// A search of sign_async, chunks are tasks of the executor and nothing waits for them.
+// The last chunk to stop running sets the result, so chunks which are still queued
+// do not delay it
+//
+template <typename HASHER>
+struct TAsyncSearch
+{
+	TAsyncSearch(const CSignKey& key, const HASHER& hasher, const SSignLimits& limits) :
+		search(key, hasher, true, limits), running(0), done(false)
+	{
+	}
+
+	TSearch<HASHER>					search;
+	std::atomic<unsigned int>		running;
+	std::atomic<bool>				done;
+	std::promise<SSignResult>		res;
+};
+
+template <typename HASHER>
+static std::future<SSignResult> search_async(const CSignKey& key, const HASHER& hasher, NExec::CExecutor& exec, const SSignLimits& limits)
+{
+	std::shared_ptr<TAsyncSearch<HASHER> > s(new TAsyncSearch<HASHER>(key, hasher, limits));
+	std::future<SSignResult> f(s->res.get_future());
+
+	for (unsigned int i = 0; i < exec.get_threads_num(); ++i)
+	{
+		exec.submit([s]()
+		{
+			++s->running;
+			s->search.run();
+
+			// A chunk returns only when the search is over, so when none is running the result is final
+			if (--s->running || s->done.exchange(true))
+				return;
+
+			try
+			{
+				SSignResult r;
+				r.status = s->search.finish(r.sig, &r.stats);
+				s->res.set_value(r);
+			}
+			catch (...)
+			{
+				s->res.set_exception(std::current_exception());
+			}
+		});
+	}
+
+	return f;
+}
+
+bool sign(const CSignKey& key, const uint8_t* msg, size_t len, SSignature& sig, NExec::CExecutor& exec, bool deterministic,
+	int counter_size, SSignStats* stats)
+{
+	if (!is_valid_counter_size(counter_size))
+		return false;
+
+	return search(key, CMsgHasher(msg, len, counter_size), sig, exec, deterministic, SSignLimits(), stats) == sign_done;
+}
+
+bool sign_document(const CSignKey& key, const uint8_t* data, size_t len, SSignature& sig, NExec::CExecutor& exec,
+	bool deterministic, SSignStats* stats)
+{
+	uint8_t digest[NSha256::digest_size];
+	NSha256::sha256(data, len, digest);
+
+	return search(key, CDocHasher(digest), sig, exec, deterministic, SSignLimits(), stats) == sign_done;
+}
+
+bool sign_document(const NCrypt::CPrivKey& priv, const NCrypt::pub_key& pub, const uint8_t* data, size_t len, SSignature& sig,
+	NExec::CExecutor& exec, bool deterministic, SSignStats* stats)
+{
+	CSignKey key(priv, pub);
+
+	return sign_document(key, data, len, sig, exec, deterministic, stats);
+}
+
+//
+// Domain separation of hashes in a Merkle tree
+//
+enum
+{
+	leaf_tag = 0,
+	node_tag = 1,
+	root_tag = 2
+};
+
+//
+// cnt items of len bytes -> cnt hashes, lanes_num items are hashed at once
+//
+static void hash_items(const uint8_t* items, size_t len, size_t cnt, uint8_t* out)
+{
+	size_t i = 0;
+	for (; i + NSha256::lanes_num <= cnt; i += NSha256::lanes_num)
+	{
+		const uint8_t* msgs[NSha256::lanes_num];
+		for (int j = 0; j < NSha256::lanes_num; ++j)
+			msgs[j] = items + (i + j) * len;
+
+		NSha256::sha256_x8(msgs, len, out + i * hash_size);
+	}
+
+	for (; i < cnt; ++i)
+		NSha256::sha256(items + i * len, len, out + i * hash_size);
+}
+
+static void hash_leaf(const uint8_t* hash, uint8_t* out)
+{
+	uint8_t item[1 + hash_size];
+	item[0] = leaf_tag;
+	memcpy(item + 1, hash, hash_size);
+
+	NSha256::sha256(item, sizeof(item), out);
+}
+
+static void hash_node(const uint8_t* left, const uint8_t* right, uint8_t* out)
+{
+	uint8_t item[1 + 2 * hash_size];
+	item[0] = node_tag;
+	memcpy(item + 1, left, hash_size);
+	memcpy(item + 1 + hash_size, right, hash_size);
+
+	NSha256::sha256(item, sizeof(item), out);
+}
+
+static void hash_root(const uint8_t* root, uint32_t leaves_num, uint8_t* out)
+{
+	uint8_t item[1 + hash_size + sizeof(leaves_num)];
+	item[0] = root_tag;
+	memcpy(item + 1, root, hash_size);
+	for (int i = 0; i < (int)sizeof(leaves_num); ++i)
+		item[1 + hash_size + i] = (uint8_t)(leaves_num >> (i << 3));
+
+	NSha256::sha256(item, sizeof(item), out);
+}
+
+bool sign_merkle(const CSignKey& key, const uint8_t* hashes, size_t n, SMerkleSignature* sigs, NExec::CExecutor& exec,
+	SSignStats* stats)
+{
+	if (!n || n > ((size_t)1 << merkle_max_depth))
+		return false;
+
+	// Level 0 holds leaves, every next level holds the nodes above
+	std::vector<std::vector<uint8_t> > levels(1);
+	std::vector<uint8_t> items(n * (1 + hash_size));
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		items[i * (1 + hash_size)] = leaf_tag;
+		memcpy(&items[i * (1 + hash_size) + 1], hashes + i * hash_size, hash_size);
+	}
+
+	levels[0].resize(n * hash_size);
+	hash_items(&items[0], 1 + hash_size, n, &levels[0][0]);
+
+	for (size_t cnt = n; cnt > 1; cnt = (cnt + 1) / 2)
+	{
+		const std::vector<uint8_t>& low(levels.back());
+		size_t pairs = cnt / 2;
+		std::vector<uint8_t> up(((cnt + 1) / 2) * hash_size);
+
+		items.resize(pairs * (1 + 2 * hash_size));
+		for (size_t i = 0; i < pairs; ++i)
+		{
+			items[i * (1 + 2 * hash_size)] = node_tag;
+			memcpy(&items[i * (1 + 2 * hash_size) + 1], &low[2 * i * hash_size], 2 * hash_size);
+		}
+
+		hash_items(&items[0], 1 + 2 * hash_size, pairs, &up[0]);
+
+		if (cnt & 1)
+			memcpy(&up[pairs * hash_size], &low[(cnt - 1) * hash_size], hash_size);
+
+		levels.push_back(up);
+	}
+
+	uint8_t digest[NSha256::digest_size];
+	hash_root(&levels.back()[0], (uint32_t)n, digest);
+
+	SSignature root;
+	if (search(key, CDocHasher(digest), root, exec, true, SSignLimits(), stats) != sign_done)
+		return false;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		SMerkleSignature& sig(sigs[i]);
+		sig.root = root;
+		sig.leaf = (uint32_t)i;
+		sig.leaves_num = (uint32_t)n;
+		sig.depth = 0;
+
+		size_t idx = i;
+		size_t cnt = n;
+		for (size_t l = 0; cnt > 1; ++l, idx >>= 1, cnt = (cnt + 1) / 2)
+		{
+			size_t pair = idx ^ 1;
+			if (pair < cnt)
+				memcpy(sig.path[sig.depth++], &levels[l][pair * hash_size], hash_size);
+		}
+	}
+
+	return true;
+}
+
+bool sign_xof(const CSignKey& key, const uint8_t* msg, size_t len, SSignature& sig, NExec::CExecutor& exec, bool deterministic,
+	int counter_size, SSignStats* stats)
+{
+	if (!is_valid_counter_size(counter_size))
+		return false;
+
+	return search(key, CXofHasher(msg, len, counter_size), sig, exec, deterministic, SSignLimits(), stats) == sign_done;
+}
+
+//
+// Search state of a message of sign_many
+//
+struct SPending
+{
+	std::atomic<uint64_t>	next;					// first counter of the next range
+	std::atomic<uint64_t>	attempts;
+	std::atomic<bool>		done;
+};
+
+//
+// A lane of hash batches of a worker: a message and a range of its counters
+//
+struct SSlot
+{
+	size_t		msg;
+	uint64_t	next;
+	uint64_t	end;
+	uint64_t	tried;
+};
+
+bool sign_many(const CSignKey& key, const uint8_t* hashes, size_t n, SSignature* sigs, NExec::CExecutor& exec)
+{
+	if (!n)
+		return true;
+
+	std::unique_ptr<SPending[]> pending(new SPending[n]);
+	for (size_t i = 0; i < n; ++i)
+	{
+		pending[i].next.store(0);
+		pending[i].attempts.store(0);
+		pending[i].done.store(false);
+	}
+
+	// Rounds which depend only on the digest of a message are done once
+	std::vector<NSha256::CSuffixHash> prefixes;
+	prefixes.reserve(n);
+	for (size_t i = 0; i < n; ++i)
+		prefixes.push_back(NSha256::CSuffixHash(hashes + i * hash_size));
+
+	std::atomic<size_t> remaining(n);
+	std::atomic<size_t> cursor(0);
+
+	// Put the slot to the next message which is not signed yet, so workers spread over
+	// pending messages and gather on the unlucky ones when others are done
+	auto refill = [&](SSlot& slot) -> bool
+	{
+		if (slot.msg < n)
+			pending[slot.msg].attempts += slot.tried;
+
+		slot.msg = n;
+		slot.tried = 0;
+
+		size_t first = cursor++;
+		for (size_t i = 0; i < n; ++i)
+		{
+			size_t m = (first + i) % n;
+			if (pending[m].done.load(std::memory_order_relaxed))
+				continue;
+
+			slot.msg = m;
+			slot.next = pending[m].next.fetch_add(sched_grain);
+			slot.end = slot.next + sched_grain;
+
+			return true;
+		}
+
+		return false;
+	};
+
+	exec.parallel_for(exec.get_threads_num() + 1, 1, [&](size_t, size_t)
+	{
+		SSlot slots[NSha256::lanes_num];
+		uint8_t digests[NSha256::lanes_num][NSha256::digest_size];
+		uint8_t cand[NCrypt::crpt_size];
+		uint8_t body[NCrypt::msg_size];
+
+		for (int j = 0; j < NSha256::lanes_num; ++j)
+		{
+			slots[j].msg = n;
+			slots[j].tried = 0;
+		}
+
+		while (remaining.load(std::memory_order_relaxed))
+		{
+			// Lanes of one hash batch may belong to different messages
+			const NSha256::CSuffixHash* lanes[NSha256::lanes_num];
+			uint64_t counters[NSha256::lanes_num];
+			int active = -1;
+
+			for (int j = 0; j < NSha256::lanes_num; ++j)
+			{
+				SSlot& slot(slots[j]);
+				if ((slot.msg >= n || slot.next == slot.end || pending[slot.msg].done.load(std::memory_order_relaxed)) && !refill(slot))
+					continue;
+
+				lanes[j] = &prefixes[slot.msg];
+				counters[j] = slot.next;
+				active = j;
+			}
+
+			if (active < 0)
+				break;
+
+			// Idle lanes repeat an active one, their results are not used
+			for (int j = 0; j < NSha256::lanes_num; ++j)
+			{
+				if (slots[j].msg >= n)
+				{
+					lanes[j] = lanes[active];
+					counters[j] = counters[active];
+				}
+			}
+
+			NSha256::CSuffixHash::hash_x8(lanes, counters, digests[0]);
+
+			for (int j = 0; j < NSha256::lanes_num; ++j)
+			{
+				SSlot& slot(slots[j]);
+				if (slot.msg >= n)
+					continue;
+
+				uint64_t counter = slot.next++;
+				++slot.tried;
+
+				memset(cand, 0, sizeof(cand));
+				memcpy(cand, digests[j], NSha256::digest_size);
+
+				if (!key.try_candidate(cand, body))
+					continue;
+
+				// The first valid counter found for a message is taken
+				if (pending[slot.msg].done.exchange(true))
+					continue;
+
+				SSignature& sig(sigs[slot.msg]);
+				sig.counter = counter;
+				sig.counter_size = max_counter_size;
+				sig.index = 0;
+				memcpy(sig.body, body, sizeof(body));
+
+				--remaining;
+			}
+		}
+
+		for (int j = 0; j < NSha256::lanes_num; ++j)
+		{
+			if (slots[j].msg < n)
+				pending[slots[j].msg].attempts += slots[j].tried;
+		}
+	});
+
+	// Only successful searches are counted, as sign does
+	for (size_t i = 0; i < n; ++i)
+		if (pending[i].done.load())
+			++g_histogram[get_log2(pending[i].attempts.load())];
+
+	return !remaining.load();
+}
+
+std::future<SSignResult> sign_async(const CSignKey& key, const uint8_t* msg, size_t len, NExec::CExecutor& exec,
+	const SSignLimits& limits, int counter_size)
+{
+	if (!is_valid_counter_size(counter_size))
+	{
+		std::promise<SSignResult> res;
+		SSignResult r;
+		r.status = sign_exhausted;
+		res.set_value(r);
+
+		return res.get_future();
+	}
+
+	// The hasher holds a copy of the message
+	return search_async(key, CMsgHasher(msg, len, counter_size), exec, limits);
+}
+
+std::future<SSignResult> sign_document_async(const CSignKey& key, const uint8_t* data, size_t len, NExec::CExecutor& exec,
+	const SSignLimits& limits)
+{
+	uint8_t digest[NSha256::digest_size];
+	NSha256::sha256(data, len, digest);
+
+	return search_async(key, CDocHasher(digest), exec, limits);
+}
+
+static bool check(const NCrypt::pub_key& pub, const uint8_t* cand, const SSignature& sig)
+{
+	uint8_t crpt[NCrypt::crpt_size];
+	NCrypt::encrypt(pub, sig.body, crpt);
+
+	return !memcmp(crpt, cand, NCrypt::crpt_size);
+}
+
+static bool is_document_signature(const SSignature& sig)
+{
+	return !sig.index && sig.counter_size == max_counter_size && is_valid_counter(sig);
+}
+
+bool verify(const NCrypt::pub_key& pub, const uint8_t* msg, size_t len, const SSignature& sig)
+{
+	if (sig.index || !is_valid_counter(sig))
+		return false;
+
+	uint8_t cand[NCrypt::crpt_size];
+	get_candidate(msg, len, sig.counter, cand, sig.counter_size);
+
+	return check(pub, cand, sig);
+}
+
+bool verify_document(const NCrypt::pub_key& pub, const uint8_t* data, size_t len, const SSignature& sig)
+{
+	if (!is_document_signature(sig))
+		return false;
+
+	uint8_t cand[NCrypt::crpt_size];
+	get_document_candidate(data, len, sig.counter, cand);
+
+	return check(pub, cand, sig);
+}
+
+// Rows selected by bodies of cnt signatures
+static void prefetch_bodies(const NCrypt::pub_key& pub, const SSignature* sigs, size_t cnt)
+{
+	NCrypt::prefetch_rows<NCrypt::crpt_size>(pub, NCrypt::TAllPositions<NCrypt::msg_size>(), sigs->body, sizeof(SSignature), cnt);
+}
+
+void verify_batch(const NCrypt::pub_key& pub, const SSignature* sigs, const uint8_t* hashes, size_t n, bool* results)
+{
+	typedef NCrypt::TRow<NCrypt::crpt_size> row;
+
+	enum
+	{
+		group = NSha256::lanes_num
+	};
+
+	if (!n)
+		return;
+
+	prefetch_bodies(pub, sigs, n < group ? n : group);
+
+	for (size_t pos = 0; pos < n; pos += group)
+	{
+		size_t cnt = n - pos < group ? n - pos : group;
+		size_t next = pos + group;
+
+		// Rows of the next group are being loaded while the current one is checked
+		if (next < n)
+			prefetch_bodies(pub, sigs + next, n - next < group ? n - next : group);
+
+		// Candidates of all signatures of the group at once, missing lanes repeat the first signature
+		uint8_t blocks[group][NSha256::CSuffixHash::msg_len];
+		const uint8_t* msgs[group];
+		uint8_t cands[group][row::lanes << 3];
+
+		for (int k = 0; k < group; ++k)
+		{
+			size_t j = pos + ((size_t)k < cnt ? k : 0);
+			memcpy(blocks[k], hashes + j * hash_size, hash_size);
+			for (int i = 0; i < max_counter_size; ++i)
+				blocks[k][hash_size + i] = (uint8_t)(sigs[j].counter >> (i << 3));
+
+			msgs[k] = blocks[k];
+		}
+
+		uint8_t digests[group][NSha256::digest_size];
+		NSha256::sha256_x8(msgs, sizeof(blocks[0]), digests[0]);
+
+		int alive[group];
+		int alive_num = 0;
+
+		for (size_t k = 0; k < cnt; ++k)
+		{
+			results[pos + k] = is_document_signature(sigs[pos + k]);
+			if (!results[pos + k])
+				continue;
+
+			memset(cands[k], 0, sizeof(cands[k]));
+			memcpy(cands[k], digests[k], NSha256::digest_size);
+			alive[alive_num++] = (int)k;
+		}
+
+		// Encrypt bodies lane by lane, a signature is dropped at its first wrong lane
+		for (int q = 0; q < row::lanes && alive_num; ++q)
+		{
+			uint64_t acc[group] = { 0 };
+
+			for (int i = 0; i < NCrypt::msg_size; ++i)
+			{
+				for (int a = 0; a < alive_num; ++a)
+				{
+					// Sizes are constant, so copies are single loads
+					const uint8_t* p = pub[i][sigs[pos + alive[a]].body[i]] + (q << 3);
+					uint64_t t(0);
+
+					if (q < row::full_lanes)
+						memcpy(&t, p, 8);
+					else
+						memcpy(&t, p, row::tail);
+
+					acc[a] ^= t;
+				}
+			}
+
+			int left = 0;
+			for (int a = 0; a < alive_num; ++a)
+			{
+				uint64_t t;
+				memcpy(&t, cands[alive[a]] + (q << 3), sizeof(t));
+
+				if (acc[a] == t)
+					alive[left++] = alive[a];
+				else
+					results[pos + alive[a]] = false;
+			}
+
+			alive_num = left;
+		}
+	}
+}
+
+bool verify_merkle(const NCrypt::pub_key& pub, const uint8_t* hash, const SMerkleSignature& sig)
+{
+	if (!is_document_signature(sig.root) || !sig.leaves_num || sig.leaf >= sig.leaves_num || sig.leaves_num > ((uint32_t)1 << merkle_max_depth))
+		return false;
+
+	uint8_t node[hash_size];
+	hash_leaf(hash, node);
+
+	int d = 0;
+	uint32_t idx = sig.leaf;
+	for (uint32_t cnt = sig.leaves_num; cnt > 1; idx >>= 1, cnt = (cnt + 1) / 2)
+	{
+		if ((idx ^ 1) >= cnt)
+			continue;
+
+		if (d >= sig.depth)
+			return false;
+
+		if (idx & 1)
+			hash_node(sig.path[d], node, node);
+		else
+			hash_node(node, sig.path[d], node);
+
+		++d;
+	}
+
+	if (d != sig.depth)
+		return false;
+
+	uint8_t digest[NSha256::digest_size];
+	uint8_t cand[NCrypt::crpt_size];
+	hash_root(node, sig.leaves_num, digest);
+
+	memset(cand, 0, NCrypt::crpt_size);
+	NSha256::CSuffixHash(digest).hash(sig.root.counter, cand);
+
+	return check(pub, cand, sig.root);
+}
+
+bool verify_xof(const NCrypt::pub_key& pub, const uint8_t* msg, size_t len, const SSignature& sig)
+{
+	if (sig.index >= xof_cands_num || !is_valid_counter(sig))
+		return false;
+
+	uint8_t cands[xof_cands_num][NCrypt::crpt_size];
+	get_xof_candidates(msg, len, sig.counter, cands[0], sig.counter_size);
+
+	return check(pub, cands[sig.index], sig);
+}
+
+}
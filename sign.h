@@ -0,0 +1,233 @@
+//***************************************************************************************
+// sign.h
+// Digital signature: search of a counter giving a hash which is a valid cipher text
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "crypt.h"
+#include "executor.h"
+#include <chrono>
+#include <future>
+
+#ifndef SIGN_H
+#define SIGN_H
+
+namespace NSign
+{
+
+enum
+{
+	sign_grain = 4096,							// Number of candidates taken by a worker at once
+	xof_cands_num = 4,							// Candidates of a counter in a block of SHAKE256 output
+	merkle_max_depth = 20,						// Up to 2^20 messages in a batch
+	hash_size = 32,								// SHA-256 of a message signed in a batch
+	default_counter_size = 4,					// Bytes of a counter appended to a message
+	max_counter_size = 8,
+	histogram_size = 64,						// Buckets of the attempts histogram
+	sched_grain = 256							// Counters of a message taken by a lane of sign_many at once
+};
+
+//
+// A candidate for a counter is SHA-256(message || counter) padded with two zero bytes.
+// About one candidate of 2^16 is a valid cipher text (its mix bytes are right),
+// the signature is the counter and the decrypted candidate. The counter is appended to a message
+// as counter_size little-endian bytes (1..max_counter_size).
+// index is the number of the candidate of the counter if there are several (zero otherwise)
+//
+struct SSignature
+{
+	uint64_t	counter;
+	uint8_t		counter_size;
+	uint8_t		index;
+	uint8_t		body[NCrypt::msg_size];
+};
+
+// crpt_size bytes
+void get_candidate(const uint8_t* msg, size_t len, uint64_t counter, uint8_t* cand, int counter_size = default_counter_size);
+// A document is hashed once, its candidate is SHA-256(SHA-256(document) || counter as 8 bytes)
+// padded with two zero bytes, so the cost of an attempt does not depend on the document size
+void get_document_candidate(const uint8_t* data, size_t len, uint64_t counter, uint8_t* cand);
+// SHAKE256(message || counter) gives xof_cands_num candidates of crpt_size bytes (a whole block of its output),
+// so a hash of a counter is shared by several attempts
+void get_xof_candidates(const uint8_t* msg, size_t len, uint64_t counter, uint8_t* cands, int counter_size = default_counter_size);
+
+//
+// Statistics of a search. Attempts are all candidates checked by all workers
+// (with a deterministic search some of them are above the returned counter)
+//
+struct SSignStats
+{
+	SSignStats();
+
+	uint64_t	attempts;
+	double		elapsed;								// seconds
+};
+
+// Bucket i counts successful searches of all threads with 2^i .. 2^(i + 1) - 1 attempts (bucket 0 includes 0)
+void get_attempts_histogram(uint64_t* counts);			// histogram_size counts
+void reset_attempts_histogram();
+
+//
+// Keys of a signer with tables for early rejection of candidates. After the inverse second
+// matrix a valid cipher text has the constant high mix byte and the low mix byte of its message.
+// Low mixes are recovered by applying the inverse second matrix to rows of public tables
+//
+class CSignKey
+{
+public:
+	// Tables of both keys are not copied and must outlive the object
+	CSignKey(const NCrypt::CPrivKey&, const NCrypt::pub_key&);
+
+private:
+	const CSignKey& operator=(const CSignKey&);
+
+public:
+	const NCrypt::CPrivKey& get_priv() const;
+	const NCrypt::pub_key& get_pub() const;
+
+	// Decrypts a candidate (crpt_size bytes) to body (msg_size bytes),
+	// returns false as soon as the candidate is known to be invalid
+	bool try_candidate(const uint8_t* cand, uint8_t* body) const;
+
+private:
+	NCrypt::CPrivKey					m_priv;				// table pointers only, so temporaries may be passed
+	const NCrypt::pub_key		*m_pub;
+	NCipher::CDecryption::check_arrays	m_check_tbxs;		// mix bytes of the inverse second matrix rows
+	NCipher::CEncryption::mix_arrays	m_mixes;			// low mix bytes
+	uint8_t								m_high_mix;
+};
+
+// Counters are split between workers of the executor, the first hit stops the search.
+// If deterministic is true the lowest valid counter is returned (the search goes on
+// until all smaller counters are checked). Returns false if no counter is valid
+bool sign(const CSignKey&, const uint8_t* msg, size_t len, SSignature&, NExec::CExecutor&, bool deterministic = true,
+	int counter_size = default_counter_size, SSignStats* = nullptr);
+bool sign(const NCrypt::CPrivKey&, const NCrypt::pub_key&, const uint8_t* msg, size_t len, SSignature&,
+	NExec::CExecutor&, bool deterministic = true, int counter_size = default_counter_size, SSignStats* = nullptr);
+
+bool verify(const NCrypt::pub_key&, const uint8_t* msg, size_t len, const SSignature&);
+
+// The same for candidates of get_document_candidate, the counter is always max_counter_size bytes
+bool sign_document(const CSignKey&, const uint8_t* data, size_t len, SSignature&, NExec::CExecutor&, bool deterministic = true,
+	SSignStats* = nullptr);
+bool sign_document(const NCrypt::CPrivKey&, const NCrypt::pub_key&, const uint8_t* data, size_t len, SSignature&,
+	NExec::CExecutor&, bool deterministic = true, SSignStats* = nullptr);
+
+bool verify_document(const NCrypt::pub_key&, const uint8_t* data, size_t len, const SSignature&);
+
+//
+// Signing of many documents given by their SHA-256 (n * hash_size bytes) at once, signatures are
+// the ones of sign_document. Lanes of every hash batch of a worker take ranges of counters of
+// different messages, a lane moves to another pending message when its message is signed, so
+// all workers gather on the unlucky messages. The first valid counter found for a message is
+// taken, so it is not always the lowest one
+//
+bool sign_many(const CSignKey&, const uint8_t* hashes, size_t n, SSignature* sigs, NExec::CExecutor&);
+
+// Signatures of sign_document for n documents given by their SHA-256 (n * hash_size bytes).
+// Signatures are re-encrypted together lane by lane (8 bytes), a signature is rejected
+// at its first wrong lane, so most forgeries cost a fraction of an encryption
+void verify_batch(const NCrypt::pub_key&, const SSignature* sigs, const uint8_t* hashes, size_t n, bool* results);
+
+//
+// Batch signature: a Merkle tree is built over hashes of messages and only its root is signed.
+// A leaf is SHA-256(0 || message hash), a node is SHA-256(1 || left || right), a node without
+// a pair goes to the next level as it is. The signed digest is SHA-256(2 || root || number of leaves)
+// and its candidates are the ones of sign_document
+//
+struct SMerkleSignature
+{
+	SSignature	root;									// signature of the root
+	uint32_t	leaf;									// number of the message in the batch
+	uint32_t	leaves_num;
+	uint8_t		depth;									// number of nodes in path
+	uint8_t		path[merkle_max_depth][hash_size];		// pairs of the nodes from the leaf to the root
+};
+
+// hashes are n * hash_size bytes, one signature for each hash.
+// Returns false if n is zero or greater than 2^merkle_max_depth
+bool sign_merkle(const CSignKey&, const uint8_t* hashes, size_t n, SMerkleSignature* sigs, NExec::CExecutor&, SSignStats* = nullptr);
+// Costs depth hashes and one encryption
+bool verify_merkle(const NCrypt::pub_key&, const uint8_t* hash, const SMerkleSignature&);
+
+//
+// Asynchronous signing
+//
+enum sign_status
+{
+	sign_done,
+	sign_exhausted,										// no counter is valid
+	sign_over_budget,
+	sign_timeout,
+	sign_cancelled
+};
+
+class CCancelToken
+{
+public:
+	CCancelToken();
+
+private:
+	CCancelToken(const CCancelToken&);
+	const CCancelToken& operator=(const CCancelToken&);
+
+public:
+	void cancel();
+	bool is_cancelled() const;
+
+private:
+	std::atomic<bool>	m_cancelled;
+};
+
+struct SSignLimits
+{
+	SSignLimits();
+
+	uint64_t								max_attempts;		// 0 - no limit
+	std::chrono::steady_clock::time_point	deadline;			// time_point::max() - no deadline
+	const CCancelToken*						cancel;				// may be null
+};
+
+struct SSignResult
+{
+	sign_status		status;
+	SSignature		sig;										// valid if status is sign_done
+	SSignStats		stats;
+};
+
+// The search runs as tasks of the executor and no thread waits for them. The message is copied
+// (a document is hashed by the caller), the key, the executor and the token must live until
+// the future is ready. Limits are checked every sign_grain attempts by running tasks, the future
+// is ready as soon as the search is stopped and none of its tasks is running.
+// The signature is the lowest valid counter within the budget, with a deadline or cancellation
+// it may be some other valid counter
+std::future<SSignResult> sign_async(const CSignKey&, const uint8_t* msg, size_t len, NExec::CExecutor&,
+	const SSignLimits& = SSignLimits(), int counter_size = default_counter_size);
+std::future<SSignResult> sign_document_async(const CSignKey&, const uint8_t* data, size_t len, NExec::CExecutor&,
+	const SSignLimits& = SSignLimits());
+
+// The same for candidates of get_xof_candidates
+bool sign_xof(const CSignKey&, const uint8_t* msg, size_t len, SSignature&, NExec::CExecutor&, bool deterministic = true,
+	int counter_size = default_counter_size, SSignStats* = nullptr);
+bool verify_xof(const NCrypt::pub_key&, const uint8_t* msg, size_t len, const SSignature&);
+
+}
+
+#endif // SIGN_H
@@ -0,0 +1,194 @@
+//***************************************************************************************
+// stream.cpp
+// Encryption and decryption of messages of arbitrary length
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "stream.h"
+#include <string.h>
+
+namespace NCrypt
+{
+
+CStreamEncryptor::CStreamEncryptor(const pub_key& key) : m_key(key), m_buf_len(0), m_final(false)
+{
+}
+
+size_t CStreamEncryptor::get_crypt_size(size_t len)
+{
+	return (len / msg_size + 1) * crpt_size;
+}
+
+size_t CStreamEncryptor::get_update_size(size_t len) const
+{
+	return ((m_buf_len + len) / msg_size) * crpt_size;
+}
+
+void CStreamEncryptor::reset()
+{
+	m_buf_len = 0;
+	m_final = false;
+}
+
+bool CStreamEncryptor::update(const uint8_t* in, size_t len, uint8_t* out, size_t out_size, size_t& written)
+{
+	written = 0;
+
+	if (m_final || out_size < get_update_size(len))
+		return false;
+
+	// Complete a block started by previous calls
+	if (m_buf_len)
+	{
+		size_t t = msg_size - m_buf_len;
+		if (t > len)
+			t = len;
+
+		memcpy(m_buf + m_buf_len, in, t);
+		m_buf_len += t;
+		in += t;
+		len -= t;
+
+		if (m_buf_len < msg_size)
+			return true;
+
+		encrypt(m_key, m_buf, out);
+		m_buf_len = 0;
+		written += crpt_size;
+	}
+
+	size_t n = len / msg_size;
+	encrypt_batch(m_key, in, n, out + written);
+	written += n * crpt_size;
+
+	m_buf_len = len - n * msg_size;
+	memcpy(m_buf, in + n * msg_size, m_buf_len);
+
+	return true;
+}
+
+bool CStreamEncryptor::final(uint8_t* out, size_t out_size, size_t& written)
+{
+	written = 0;
+
+	if (m_final || out_size < crpt_size)
+		return false;
+
+	uint8_t p = (uint8_t)(msg_size - m_buf_len);
+	memset(m_buf + m_buf_len, p, p);
+
+	encrypt(m_key, m_buf, out);
+	written = crpt_size;
+
+	m_buf_len = 0;
+	m_final = true;
+
+	return true;
+}
+
+CStreamDecryptor::CStreamDecryptor(const CPrivKey& key) : m_key(key), m_buf_len(0), m_final(false)
+{
+}
+
+size_t CStreamDecryptor::get_update_size(size_t len) const
+{
+	return ((m_buf_len + len) / crpt_size) * msg_size;
+}
+
+void CStreamDecryptor::reset()
+{
+	m_buf_len = 0;
+	m_final = false;
+}
+
+bool CStreamDecryptor::update(const uint8_t* in, size_t len, uint8_t* out, size_t out_size, size_t& written)
+{
+	written = 0;
+
+	if (m_final || out_size < get_update_size(len))
+		return false;
+
+	if (!len)
+		return true;
+
+	if (m_buf_len)
+	{
+		size_t t = crpt_size - m_buf_len;
+		if (t > len)
+			t = len;
+
+		memcpy(m_buf + m_buf_len, in, t);
+		m_buf_len += t;
+		in += t;
+		len -= t;
+
+		// The buffered block is decrypted only when it is not the last one
+		if (m_buf_len < crpt_size || !len)
+			return true;
+
+		decrypt(m_key, m_buf, out);
+		m_buf_len = 0;
+		written += msg_size;
+	}
+
+	// Keep at least one byte (a whole block if len is aligned) for final()
+	size_t n = (len - 1) / crpt_size;
+	decrypt_batch(m_key, in, n, out + written);
+	written += n * msg_size;
+
+	m_buf_len = len - n * crpt_size;
+	memcpy(m_buf, in + n * crpt_size, m_buf_len);
+
+	return true;
+}
+
+bool CStreamDecryptor::final(uint8_t* out, size_t out_size, size_t& written)
+{
+	written = 0;
+
+	if (m_final || m_buf_len != crpt_size)
+		return false;
+
+	uint8_t msg[msg_size];
+	decrypt(m_key, m_buf, msg);
+
+	uint8_t p = msg[msg_size - 1];
+	if (!p || p > msg_size)
+		return false;
+
+	for (size_t i = msg_size - p; i < msg_size; ++i)
+	{
+		if (msg[i] != p)
+			return false;
+	}
+
+	if (out_size < (size_t)(msg_size - p))
+		return false;
+
+	memcpy(out, msg, msg_size - p);
+	written = msg_size - p;
+
+	m_buf_len = 0;
+	m_final = true;
+
+	return true;
+}
+
+}
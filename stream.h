@@ -0,0 +1,93 @@
+//***************************************************************************************
+// stream.h
+// Encryption and decryption of messages of arbitrary length
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "crypt.h"
+
+#ifndef STREAM_H
+#define STREAM_H
+
+namespace NCrypt
+{
+
+//
+// A message is split into blocks of msg_size bytes, the last block is padded
+// with p bytes of value p (1 <= p <= msg_size), so there is always a padded block.
+// Whole blocks are encrypted straight from an input buffer to an output buffer
+//
+class CStreamEncryptor
+{
+public:
+	CStreamEncryptor(const pub_key&);
+
+private:
+	const CStreamEncryptor& operator=(const CStreamEncryptor&);
+
+public:
+	// Size of the encrypted message of the given length
+	static size_t get_crypt_size(size_t);
+
+	// Maximal number of bytes written by update() for the given input length
+	size_t get_update_size(size_t) const;
+
+	bool update(const uint8_t* in, size_t len, uint8_t* out, size_t out_size, size_t& written);
+	// Writes crpt_size bytes
+	bool final(uint8_t* out, size_t out_size, size_t& written);
+	void reset();
+
+private:
+	const pub_key&		m_key;
+	uint8_t				m_buf[msg_size];
+	size_t				m_buf_len;
+	bool				m_final;
+};
+
+//
+// The last encrypted block is kept until final(), because it holds the padding
+//
+class CStreamDecryptor
+{
+public:
+	CStreamDecryptor(const CPrivKey&);
+
+private:
+	const CStreamDecryptor& operator=(const CStreamDecryptor&);
+
+public:
+	// Maximal number of bytes written by update() for the given input length
+	size_t get_update_size(size_t) const;
+
+	bool update(const uint8_t* in, size_t len, uint8_t* out, size_t out_size, size_t& written);
+	// Writes at most msg_size - 1 bytes, fails if the input is truncated or the padding is wrong
+	bool final(uint8_t* out, size_t out_size, size_t& written);
+	void reset();
+
+private:
+	CPrivKey			m_key;				// holds only table pointers, so a temporary key may be passed
+	uint8_t				m_buf[crpt_size];
+	size_t				m_buf_len;
+	bool				m_final;
+};
+
+}
+
+#endif // STREAM_H
@@ -0,0 +1,305 @@
+//***************************************************************************************
+// tblrow.h
+// Operations with rows of T-box tables
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define WB_PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define WB_PREFETCH(p) ((void)(p))
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WB_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifndef TBLROW_H
+#define TBLROW_H
+
+namespace NCrypt
+{
+
+//
+// A row of SIZE bytes is processed as 8-byte lanes, the last lane may be incomplete
+//
+template <int SIZE>
+struct TRow
+{
+	enum
+	{
+		lanes = (SIZE + 7) / 8,
+		full_lanes = SIZE / 8,
+		tail = SIZE % 8
+	};
+};
+
+template <int SIZE>
+inline void clear_row(uint64_t* acc)
+{
+	for (int i = 0; i < TRow<SIZE>::lanes; ++i)
+		acc[i] = 0;
+}
+
+template <int SIZE>
+inline void xor_row(uint64_t* acc, const uint8_t* row)
+{
+	for (int i = 0; i < TRow<SIZE>::full_lanes; ++i)
+	{
+		uint64_t t;
+		memcpy(&t, row + (i << 3), sizeof(t));
+		acc[i] ^= t;
+	}
+
+	if (TRow<SIZE>::tail != 0)
+	{
+		uint64_t t(0);
+		memcpy(&t, row + (TRow<SIZE>::full_lanes << 3), TRow<SIZE>::tail);
+		acc[TRow<SIZE>::lanes - 1] ^= t;
+	}
+}
+
+template <int SIZE>
+inline void load_row(uint64_t* acc, const uint8_t* row)
+{
+	clear_row<SIZE>(acc);
+	xor_row<SIZE>(acc, row);
+}
+
+template <int SIZE>
+inline void store_row(uint8_t* row, const uint64_t* acc)
+{
+	for (int i = 0; i < TRow<SIZE>::full_lanes; ++i)
+		memcpy(row + (i << 3), &acc[i], sizeof(uint64_t));
+
+	if (TRow<SIZE>::tail != 0)
+		memcpy(row + (TRow<SIZE>::full_lanes << 3), &acc[TRow<SIZE>::lanes - 1], TRow<SIZE>::tail);
+}
+
+// Rows are not aligned to cache lines, so both ends of a row are touched
+template <int SIZE>
+inline void prefetch_row(const uint8_t* row)
+{
+	WB_PREFETCH(row);
+	WB_PREFETCH(row + SIZE - 1);
+}
+
+//
+// Position lists for the functions below: inputs are bytes, a row is selected by the
+// byte at every listed position
+//
+
+// Positions 0 .. IN - 1
+template <int IN>
+struct TAllPositions
+{
+	int size() const
+	{
+		return IN;
+	}
+
+	int operator[](int j) const
+	{
+		return j;
+	}
+};
+
+// Positions listed in an array
+class CPositionList
+{
+public:
+	CPositionList(const uint8_t* pos, int num) : m_pos(pos), m_num(num)
+	{
+	}
+
+public:
+	int size() const
+	{
+		return m_num;
+	}
+
+	int operator[](int j) const
+	{
+		return m_pos[j];
+	}
+
+private:
+	const uint8_t	*m_pos;
+	int				m_num;
+};
+
+//
+// tbls[i][b] is a row of OUT bytes, cnt inputs are stride bytes apart
+//
+
+// Prefetch rows tbls[i][in[i]] of cnt inputs
+template <int OUT, typename TBLS, typename POS>
+inline void prefetch_rows(const TBLS& tbls, const POS& pos, const uint8_t* in, size_t stride, size_t cnt)
+{
+	for (size_t k = 0; k < cnt; ++k)
+	{
+		for (int j = 0; j < pos.size(); ++j)
+			prefetch_row<OUT>(tbls[pos[j]][in[k * stride + pos[j]]]);
+	}
+}
+
+// out + k * OUT = base ^ XOR of tbls[i][in[i]] of input k, k < cnt <= WIDTH (base = 0 if null)
+// Inputs are interleaved, so loads of different inputs overlap
+template <int OUT, int WIDTH, typename TBLS, typename POS>
+inline void xor_rows(const TBLS& tbls, const POS& pos, const uint64_t* base, const uint8_t* in, size_t stride, size_t cnt,
+	uint8_t* out)
+{
+	uint64_t acc[WIDTH][TRow<OUT>::lanes];
+	for (size_t k = 0; k < cnt; ++k)
+	{
+		if (base)
+			memcpy(acc[k], base, sizeof(acc[k]));
+		else
+			clear_row<OUT>(acc[k]);
+	}
+
+	for (int j = 0; j < pos.size(); ++j)
+	{
+		int i = pos[j];
+		for (size_t k = 0; k < cnt; ++k)
+			xor_row<OUT>(acc[k], tbls[i][in[k * stride + i]]);
+	}
+
+	for (size_t k = 0; k < cnt; ++k)
+		store_row<OUT>(out + k * OUT, acc[k]);
+}
+
+// The same for n inputs in groups of WIDTH, rows of the next group are being loaded
+// while the current one is accumulated
+template <int OUT, int WIDTH, typename TBLS, typename POS>
+inline void xor_rows_batch(const TBLS& tbls, const POS& pos, const uint64_t* base, const uint8_t* in, size_t stride, size_t n,
+	uint8_t* out)
+{
+	if (!n)
+		return;
+
+	prefetch_rows<OUT>(tbls, pos, in, stride, n < WIDTH ? n : WIDTH);
+
+	for (size_t p = 0; p < n; p += WIDTH)
+	{
+		size_t next = p + WIDTH;
+
+		if (next < n)
+			prefetch_rows<OUT>(tbls, pos, in + next * stride, stride, n - next < WIDTH ? n - next : WIDTH);
+
+		xor_rows<OUT, WIDTH>(tbls, pos, base, in + p * stride, stride, n - p < WIDTH ? n - p : WIDTH, out + p * OUT);
+	}
+}
+
+// Bit i is set if a[i] != b[i], i < 32
+inline uint32_t get_diff_mask32(const uint8_t* a, const uint8_t* b)
+{
+#ifdef WB_SSE2
+	__m128i a0 = _mm_loadu_si128((const __m128i*)a);
+	__m128i a1 = _mm_loadu_si128((const __m128i*)(a + 16));
+	__m128i b0 = _mm_loadu_si128((const __m128i*)b);
+	__m128i b1 = _mm_loadu_si128((const __m128i*)(b + 16));
+
+	uint32_t eq = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a0, b0)) |
+		((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a1, b1)) << 16);
+
+	return ~eq;
+#else
+	uint32_t m(0);
+	for (int i = 0; i < 32; ++i)
+		m |= (uint32_t)(a[i] != b[i]) << i;
+
+	return m;
+#endif // WB_SSE2
+}
+
+// Bit i is set if a[i] != 0, i < 32
+inline uint32_t get_nonzero_mask32(const uint8_t* a)
+{
+#ifdef WB_SSE2
+	__m128i z = _mm_setzero_si128();
+	__m128i a0 = _mm_loadu_si128((const __m128i*)a);
+	__m128i a1 = _mm_loadu_si128((const __m128i*)(a + 16));
+
+	uint32_t eq = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a0, z)) |
+		((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a1, z)) << 16);
+
+	return ~eq;
+#else
+	uint32_t m(0);
+	for (int i = 0; i < 32; ++i)
+		m |= (uint32_t)(a[i] != 0) << i;
+
+	return m;
+#endif // WB_SSE2
+}
+
+// XOR of all bits
+inline uint64_t get_parity(uint64_t x)
+{
+#if defined(__GNUC__)
+	return (uint64_t)__builtin_parityll(x);
+#else
+	x ^= x >> 32;
+	x ^= x >> 16;
+	x ^= x >> 8;
+	x ^= x >> 4;
+	x ^= x >> 2;
+	x ^= x >> 1;
+
+	return x & 1;
+#endif // __GNUC__
+}
+
+// Index of the lowest set bit of a non-zero mask, the bit is cleared
+inline int pop_lowest_bit(uint32_t& m)
+{
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward(&i, m);
+#else
+	int i = __builtin_ctz(m);
+#endif // _MSC_VER
+	m &= m - 1;
+
+	return (int)i;
+}
+
+inline int pop_lowest_bit(uint64_t& m)
+{
+	uint32_t t = (uint32_t)m;
+	int i = t ? pop_lowest_bit(t) : 32 + pop_lowest_bit(t = (uint32_t)(m >> 32));
+	m &= m - 1;
+
+	return i;
+}
+
+}
+
+#endif // TBLROW_H
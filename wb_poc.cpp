@@ -24,9 +24,24 @@
 
 #include "stdafx.h"
 #include "savekeys.h"
+#include "crypt.h"
+#include "sign.h"
+#include "hybrid.h"
+#include "owner.h"
+#include "gfdecr.h"
+#include "bsdecr.h"
+#include "sha256.h"
+#include "shake.h"
+#include "stream.h"
+#include "partial.h"
+#include "rebase.h"
+#include "mdecr.h"
+
+#include <stdexcept>
 
 using namespace NCipher;
 using namespace NSaveKeys;
+using namespace NCrypt;
 
 // Source message
 char msg[] = "This is fast white-box cipher!!";
@@ -199,21 +214,67 @@ bool test_encr_decr_save_load()
 	return !memcmp(msg, t2, CEncryption::comb_sbsts_num);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_encr_decr_batch()
+//
+// Generate a key pair, encrypt a batch of random messages with a public key,
+// decrypt the batch with a private key, compare with one-by-one encryption
+// and check the result
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_encr_decr_batch()
+{
+	const size_t n = 1000;
+
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	CPrivKey prv(*d);
+
+	uint8_t *msgs = new uint8_t[n * msg_size];
+	uint8_t *crpts = new uint8_t[n * crpt_size];
+	uint8_t *res = new uint8_t[n * msg_size];
+
+	NPrng::get_rnd(msgs, n * msg_size);
+
+	encrypt_batch(e->get_comb_tbxs(), msgs, n, crpts);
+	decrypt_batch(prv, crpts, n, res);
+
+	bool ok = !memcmp(msgs, res, n * msg_size);
+
+	// Batch and single message functions must give the same results
+	for (size_t i = 0; i < n && ok; ++i)
+	{
+		uint8_t crpt[crpt_size];
+		uint8_t dmsg[msg_size];
+
+		encrypt(e->get_comb_tbxs(), msgs + i * msg_size, crpt);
+		decrypt(prv, crpt, dmsg);
+
+		ok = !memcmp(crpt, crpts + i * crpt_size, crpt_size) && !memcmp(dmsg, msgs + i * msg_size, msg_size);
+	}
+
+	delete[] msgs;
+	delete[] crpts;
+	delete[] res;
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////
 // test_sign()
 //
-// Sample of a digital signature algorithm
+// Sample of a digital signature algorithm. Sign a message with keys loaded from files,
+// verify the signature, check statistics of the search and the attempts histogram.
+// With a one-byte counter only 256 candidates exist, so a search usually fails
 /////////////////////////////////////////////////////////////////////////////////////////
 bool test_sign()
 {
-	// A size of msg_to_sign must be 3 bytes more than a size of msg (i.e. 16 + 3 = 19 bytes)
-	// So, a size of an additional counter is 3 bytes
-	char msg_to_sign[CEncryption::tbox_size + 1]; // +1
-	memset(msg_to_sign, 0, sizeof(msg_to_sign));
-
-	memcpy_s(msg_to_sign, sizeof(msg_to_sign), msg, sizeof(msg));
-	uint8_t hsh[32];
-	
 	// Generate a key pair
 	CEncryption *e = new CEncryption();
 	e->gen_key();
@@ -248,117 +309,2004 @@ bool test_sign()
 	uint8_t *pub = load_public_key(efile);
 	uint8_t *prv = load_priv_key(dfile);
 
-	const NCipher::CEncryption::comb_tbox_arrays &pub_tbxs = *((const NCipher::CEncryption::comb_tbox_arrays*)pub);
-	const NCipher::CDecryption::mixed_comb_tbox_arrays &prv_tbxs2 = *((const NCipher::CDecryption::mixed_comb_tbox_arrays*)prv);
-	const NCipher::CDecryption::clear_comb_tbox_arrays &prv_tbxs1 = *((const NCipher::CDecryption::clear_comb_tbox_arrays*)(prv + sizeof(NCipher::CDecryption::mixed_comb_tbox_arrays)));
-	const NCipher::CDecryption::clear_comb_tbox_arrays &prv_tbxs0 = *((const NCipher::CDecryption::clear_comb_tbox_arrays*)(prv + sizeof(NCipher::CDecryption::mixed_comb_tbox_arrays) + sizeof(NCipher::CDecryption::clear_comb_tbox_arrays)));
+	NExec::CExecutor exec;
+	NSign::CSignKey key(CPrivKey(prv), get_pub_key(pub));
+	NSign::SSignature sig;
+	NSign::SSignStats stats;
+	uint64_t counts[NSign::histogram_size];
 
-	// Sign a source message
-	// For this PoC we use low 18 bits of SHA-256
-	for (unsigned int i = 0; i < 0x1000000; ++i)
-	{
-		msg_to_sign[32] = (unsigned char)i;
-		msg_to_sign[33] = (unsigned char)(i >> 8);
-		msg_to_sign[34] = (unsigned char)(i >> 16); // +1
+	// Sign a source message, a counter of default_counter_size bytes is appended to it
+	NSign::reset_attempts_histogram();
+
+	bool ok = NSign::sign(key, (const uint8_t*)msg, sizeof(msg), sig, exec, true, NSign::default_counter_size, &stats);
+	ok = ok && sig.counter_size == NSign::default_counter_size && !sig.index;
+	ok = ok && NSign::verify(get_pub_key(pub), (const uint8_t*)msg, sizeof(msg), sig);
+	ok = ok && !NSign::verify(get_pub_key(pub), (const uint8_t*)msg, sizeof(msg) - 1, sig);
 
-		NPrng::sha2(msg_to_sign, sizeof(msg_to_sign), hsh, sizeof(hsh));
+	// All counters up to the returned one are tried, the success is counted once
+	ok = ok && stats.attempts > sig.counter && stats.elapsed > 0;
 
-		
-		// Decrypt low bits of hash
-		uint8_t t0[CEncryption::tbox_size];
-		memset(t0, 0, CEncryption::tbox_size);
+	int bucket = 0;
+	for (uint64_t v = stats.attempts; v >>= 1;)
+		++bucket;
+
+	NSign::get_attempts_histogram(counts);
+	for (int i = 0; i < NSign::histogram_size; ++i)
+		ok = ok && counts[i] == (i == bucket ? 1u : 0u);
+
+	// Sizes of a counter out of range
+	ok = ok && !NSign::sign(key, (const uint8_t*)msg, sizeof(msg), sig, exec, true, 0);
+	ok = ok && !NSign::sign(key, (const uint8_t*)msg, sizeof(msg), sig, exec, true, NSign::max_counter_size + 1);
+
+	// A one-byte counter: one message of 256 has a valid counter, the others must be exhausted
+	bool exhausted = false;
+	uint64_t signed_num = 1;
+	for (int i = 0; ok && !exhausted && i < 16; ++i)
+	{
+		char m[sizeof(msg)];
+		memcpy(m, msg, sizeof(msg));
+		m[0] = (char)('A' + i);
 
-		for (int j = 0; j < CEncryption::tbox_size; ++j)
+		if (NSign::sign(key, (const uint8_t*)m, sizeof(m), sig, exec, true, 1, &stats))
 		{
-			for (int i = 0; i < CEncryption::tbox_size; ++i)
-			{
-				t0[j] ^= prv_tbxs2[i][hsh[i]][j];
-			}
+			ok = sig.counter < 0x100 && NSign::verify(get_pub_key(pub), (const uint8_t*)m, sizeof(m), sig);
+			++signed_num;
+			continue;
 		}
 
-		uint8_t t1[CEncryption::comb_sbsts_num];
-		memset(t1, 0, CEncryption::comb_sbsts_num);
-		for (int j = 0; j < CEncryption::comb_sbsts_num; ++j)
+		exhausted = true;
+		ok = stats.attempts == 0x100;
+
+		NSign::SSignResult r = NSign::sign_async(key, (const uint8_t*)m, sizeof(m), exec, NSign::SSignLimits(), 1).get();
+		ok = ok && r.status == NSign::sign_exhausted && r.stats.attempts == 0x100;
+	}
+
+	// Failed searches are not counted
+	NSign::get_attempts_histogram(counts);
+	uint64_t total(0);
+	for (int i = 0; i < NSign::histogram_size; ++i)
+		total += counts[i];
+
+	ok = ok && exhausted && total == signed_num;
+
+	NSign::reset_attempts_histogram();
+
+	delete[] pub;
+	delete[] prv;
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_sign_parallel()
+//
+// Generate a key pair, sign a message with all hardware threads,
+// verify the signature and check that a changed message is rejected
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_sign_parallel()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	NExec::CExecutor exec;
+	NSign::SSignature sig;
+
+	bool ok = NSign::sign(CPrivKey(*d), e->get_comb_tbxs(), (const uint8_t*)msg, sizeof(msg), sig, exec);
+	ok = ok && NSign::verify(e->get_comb_tbxs(), (const uint8_t*)msg, sizeof(msg), sig);
+	ok = ok && !NSign::verify(e->get_comb_tbxs(), (const uint8_t*)msg, sizeof(msg) - 1, sig);
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_executor()
+//
+// Run submitted tasks and nested parallel loops, check that every index is visited
+// exactly once and that an exception thrown by a chunk reaches the caller
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_executor()
+{
+	const size_t n = 10000;
+
+	NExec::CExecutor exec;
+
+	std::atomic<int> *visits = new std::atomic<int>[n];
+	for (size_t i = 0; i < n; ++i)
+		visits[i] = 0;
+
+	exec.parallel_for(n, 7, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			++visits[i];
+	});
+
+	bool ok = true;
+	for (size_t i = 0; i < n; ++i)
+		ok = ok && visits[i] == 1;
+
+	delete[] visits;
+
+	// Nested loops, the outer chunks wait for the inner ones
+	std::atomic<size_t> cnt(0);
+	exec.parallel_for(16, 1, [&](size_t, size_t)
+	{
+		exec.parallel_for(100, 3, [&](size_t begin, size_t end)
 		{
-			for (int i = 0; i < CEncryption::comb_sbsts_num; ++i)
-			{
-				t1[j] ^= prv_tbxs1[i][t0[i]][j];
-			}
-		}
+			cnt += end - begin;
+		});
+	});
+	ok = ok && cnt == 1600;
 
-		uint8_t t2[CEncryption::comb_sbsts_num];
-		memset(t2, 0, CEncryption::comb_sbsts_num);
-		for (int j = 0; j < CEncryption::comb_sbsts_num; ++j)
+	// Independent tasks
+	std::atomic<int> done(0);
+	for (int i = 0; i < 100; ++i)
+		exec.submit([&done]() { ++done; });
+	while (done != 100)
+		std::this_thread::yield();
+
+	// The failed chunk does not stop the others and the exception is rethrown by the caller
+	bool thrown = false;
+	cnt = 0;
+	try
+	{
+		exec.parallel_for(n, 10, [&](size_t begin, size_t end)
 		{
-			for (int i = 0; i < CEncryption::comb_sbsts_num; ++i)
-			{
-				t2[j] ^= prv_tbxs0[i][t1[i]][j];
-			}
-		}
+			if (begin == 500)
+				throw std::runtime_error("chunk failed");
+			cnt += end - begin;
+		});
+	}
+	catch (const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	ok = ok && thrown && cnt == n - 10;
 
-		// try to encrypt t2
-		uint8_t crpt[CEncryption::tbox_size];
-		memset(crpt, 0, CEncryption::tbox_size);
+	// The executor is still usable
+	cnt = 0;
+	exec.parallel_for(n, 100, [&](size_t begin, size_t end)
+	{
+		cnt += end - begin;
+	});
+	ok = ok && cnt == n;
 
-		for (int j = 0; j < CEncryption::tbox_size; ++j)
+	// Tasks which are queued when the executor is destroyed still run
+	done = 0;
+	{
+		NExec::CExecutor one(1);
+		for (int i = 0; i < 100; ++i)
 		{
-			for (int i = 0; i < CEncryption::comb_sbsts_num; ++i)
+			one.submit([&done]()
 			{
-				crpt[j] ^= pub_tbxs[i][t2[i]][j];
-			}
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+				++done;
+			});
 		}
+	}
+
+	return ok && done == 100;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_aead()
+//
+// Check ChaCha20-Poly1305 with the test vector of RFC 8439 (2.8.2), check that
+// changed cipher texts, associated data and tags are rejected by AEAD and
+// hybrid decryption
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_aead()
+{
+	static const uint8_t key[NChaCha::key_size] =
+	{
+		0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+		0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f
+	};
+	static const uint8_t nonce[NChaCha::nonce_size] =
+	{
+		0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47
+	};
+	static const uint8_t aad[] =
+	{
+		0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7
+	};
+	static const char plain[] = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip "
+		"for the future, sunscreen would be it.";
+	static const uint8_t crpt[] =
+	{
+		0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb, 0x7b, 0x86, 0xaf, 0xbc, 0x53, 0xef, 0x7e, 0xc2,
+		0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe, 0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6,
+		0x3d, 0xbe, 0xa4, 0x5e, 0x8c, 0xa9, 0x67, 0x12, 0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+		0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29, 0x05, 0xd6, 0xa5, 0xb6, 0x7e, 0xcd, 0x3b, 0x36,
+		0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c, 0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58,
+		0xfa, 0xb3, 0x24, 0xe4, 0xfa, 0xd6, 0x75, 0x94, 0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+		0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d, 0xe5, 0x76, 0xd2, 0x65, 0x86, 0xce, 0xc6, 0x4b,
+		0x61, 0x16
+	};
+	static const uint8_t tag[NChaCha::tag_size] =
+	{
+		0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a, 0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91
+	};
+
+	const size_t len = sizeof(crpt);
+	if (sizeof(plain) - 1 != len)
+		return false;
+
+	uint8_t out[sizeof(crpt)];
+	uint8_t out_tag[NChaCha::tag_size];
+
+	NChaCha::aead_encrypt(key, nonce, aad, sizeof(aad), (const uint8_t*)plain, len, out, out_tag);
+	bool ok = !memcmp(out, crpt, len) && !memcmp(out_tag, tag, sizeof(tag));
+
+	memset(out, 0, len);
+	ok = ok && NChaCha::aead_decrypt(key, nonce, aad, sizeof(aad), crpt, len, out, tag) && !memcmp(out, plain, len);
+
+	// A changed bit anywhere must be detected
+	uint8_t bad_crpt[sizeof(crpt)];
+	uint8_t bad_aad[sizeof(aad)];
+	uint8_t bad_tag[sizeof(tag)];
+
+	memcpy(bad_crpt, crpt, len);
+	bad_crpt[len - 1] ^= 1;
+	ok = ok && !NChaCha::aead_decrypt(key, nonce, aad, sizeof(aad), bad_crpt, len, out, tag);
+
+	memcpy(bad_aad, aad, sizeof(aad));
+	bad_aad[0] ^= 0x80;
+	ok = ok && !NChaCha::aead_decrypt(key, nonce, bad_aad, sizeof(aad), crpt, len, out, tag);
+
+	memcpy(bad_tag, tag, sizeof(tag));
+	bad_tag[7] ^= 4;
+	ok = ok && !NChaCha::aead_decrypt(key, nonce, aad, sizeof(aad), crpt, len, out, bad_tag);
+
+	if (!ok)
+		return false;
+
+	// Hybrid encryption, both the encrypted session key and the body are authenticated
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	CPrivKey prv(*d);
+
+	const size_t hlen = get_hybrid_crypt_size(len);
+	uint8_t *hcrpt = new uint8_t[hlen];
+
+	ok = hybrid_encrypt(e->get_comb_tbxs(), (const uint8_t*)plain, len, hcrpt, hlen);
+	ok = ok && hybrid_decrypt(prv, hcrpt, hlen, out, len) && !memcmp(out, plain, len);
+
+	hcrpt[3] ^= 1;
+	ok = ok && !hybrid_decrypt(prv, hcrpt, hlen, out, len);
+	hcrpt[3] ^= 1;
+
+	hcrpt[crpt_size + 5] ^= 1;
+	ok = ok && !hybrid_decrypt(prv, hcrpt, hlen, out, len);
+	hcrpt[crpt_size + 5] ^= 1;
+
+	ok = ok && !hybrid_decrypt(prv, hcrpt, hlen - 1, out, len);
+
+	delete[] hcrpt;
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_owner()
+//
+// Encrypt random messages with the owner key one by one and in a batch,
+// compare with encryption by the public key
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_owner()
+{
+	const size_t n = 1000;
+
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	COwnerKey *owner = new COwnerKey(*e);
+
+	uint8_t *msgs = new uint8_t[n * msg_size];
+	uint8_t *crpts = new uint8_t[n * crpt_size];
+
+	NPrng::get_rnd(msgs, n * msg_size);
+	owner->encrypt_batch(msgs, n, crpts);
+
+	bool ok = true;
+	for (size_t i = 0; i < n && ok; ++i)
+	{
+		uint8_t crpt[crpt_size];
+		uint8_t ocrpt[crpt_size];
+
+		encrypt(e->get_comb_tbxs(), msgs + i * msg_size, crpt);
+		owner->encrypt(msgs + i * msg_size, ocrpt);
+
+		ok = !memcmp(crpt, ocrpt, crpt_size) && !memcmp(crpt, crpts + i * crpt_size, crpt_size);
+	}
+
+	delete[] msgs;
+	delete[] crpts;
+
+	delete owner;
+	delete e;
 
-		// compare source bytes of hash and crpt
-		if (!memcmp(hsh, crpt, CEncryption::tbox_size))
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_gfni_decr()
+//
+// Decrypt random cipher texts with every backend of CGfniDecryption supported by CPU,
+// compare with table decryption
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_gfni_decr()
+{
+	// Not a multiple of the group size, so the last group is incomplete
+	const size_t n = 1003;
+
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	CPrivKey prv(*d);
+	CGfniDecryption *gd = new CGfniDecryption(*d);
+
+	uint8_t *msgs = new uint8_t[n * msg_size];
+	uint8_t *crpts = new uint8_t[n * crpt_size];
+	uint8_t *res = new uint8_t[n * msg_size];
+
+	NPrng::get_rnd(msgs, n * msg_size);
+	encrypt_batch(e->get_comb_tbxs(), msgs, n, crpts);
+
+	const CGfniDecryption::backend backends[] =
+	{
+		CGfniDecryption::scalar_backend, CGfniDecryption::avx2_backend, CGfniDecryption::avx512_backend
+	};
+
+	// The scalar backend is always available
+	bool ok = gd->set_backend(CGfniDecryption::scalar_backend);
+
+	for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]) && ok; ++b)
+	{
+		if (!gd->set_backend(backends[b]))
+			continue;
+
+		memset(res, 0, n * msg_size);
+		gd->decrypt_batch(crpts, n, res);
+
+		for (size_t i = 0; i < n && ok; ++i)
 		{
-			delete[] pub;
-			delete[] prv;
+			uint8_t m0[msg_size];
+			uint8_t m1[msg_size];
 
-			delete d;
-			delete e;
+			decrypt(prv, crpts + i * crpt_size, m0);
+			gd->decrypt(crpts + i * crpt_size, m1);
 
-			return true;
+			ok = !memcmp(m0, msgs + i * msg_size, msg_size) && !memcmp(m0, m1, msg_size) &&
+				!memcmp(m0, res + i * msg_size, msg_size);
 		}
 	}
 
-	delete[] pub;
-	delete[] prv;
+	delete[] msgs;
+	delete[] crpts;
+	delete[] res;
 
+	delete gd;
 	delete d;
 	delete e;
 
-	return false;
+	return ok;
 }
 
-int main(int argc, char* argv[])
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_bitsliced_decr()
+//
+// Decrypt random batches with 64-bit and (if CPU supports AVX2) 256-bit planes,
+// compare with table decryption. Batch sizes include incomplete blocks
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_bitsliced_decr()
 {
-	for (;;)
+	const size_t sizes[] =
 	{
-		if (!test_sign())
-		{
-			printf_s("SIGNATURE ERROR!!!\n");
-		}
-		else
-		{
-			printf_s("SIGNATURE OK!!!\n");
-		}
+		1, CBitslicedDecryption::block_size - 1, CBitslicedDecryption::block_size + 1, CBitslicedDecryption::wide_block_size,
+		CBitslicedDecryption::wide_block_size + CBitslicedDecryption::block_size + 37
+	};
+	const size_t max_n = CBitslicedDecryption::wide_block_size + CBitslicedDecryption::block_size + 37;
 
-		if (!test_encr_decr())
-		{
-			printf_s("ENCR_DECR ERROR!!!\n");
-		}
-		else
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	CPrivKey prv(*d);
+	CBitslicedDecryption *bd = new CBitslicedDecryption(*d);
+
+	uint8_t *msgs = new uint8_t[max_n * msg_size];
+	uint8_t *crpts = new uint8_t[max_n * crpt_size];
+	uint8_t *res0 = new uint8_t[max_n * msg_size];
+	uint8_t *res1 = new uint8_t[max_n * msg_size];
+
+	bool ok = true;
+	for (int wide = 0; wide < 2 && ok; ++wide)
+	{
+		if (!bd->set_wide(wide != 0))
+			continue;
+
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && ok; ++s)
 		{
-			printf_s("ENCR_DECR OK!!!\n");
+			size_t n = sizes[s];
+
+			NPrng::get_rnd(msgs, (uint32_t)(n * msg_size));
+			encrypt_batch(e->get_comb_tbxs(), msgs, n, crpts);
+
+			memset(res1, 0, n * msg_size);
+			decrypt_batch(prv, crpts, n, res0);
+			bd->decrypt_batch(crpts, n, res1);
+
+			ok = !memcmp(res0, msgs, n * msg_size) && !memcmp(res0, res1, n * msg_size);
 		}
+	}
 
-		if (!test_encr_decr_save_load())
+	delete[] msgs;
+	delete[] crpts;
+	delete[] res0;
+	delete[] res1;
+
+	delete bd;
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+//
+// Operations over 64-bit planes for CXorProgram::run
+//
+struct SPlanes64
+{
+	enum
+	{
+		lanes = 1
+	};
+
+	static void set(uint64_t* d, uint64_t v)
+	{
+		*d = v;
+	}
+
+	static void xor_of(uint64_t* d, const uint64_t* a, const uint64_t* b)
+	{
+		*d = *a ^ *b;
+	}
+};
+
+//
+// Run the program of the first rows rows of m for 64 random vectors (bit t of input
+// plane j is bit j of vector t), compare with multiplication by m
+//
+template <int N, int M>
+static bool check_xor_program(const NBMatrix::TBMatrix<N, M>& m, int rows)
+{
+	CXorProgram prog(m, rows);
+
+	std::vector<uint64_t> regs(prog.get_regs_num());
+	NPrng::get_rnd(&regs[prog.get_in_base()], M * sizeof(uint64_t));
+
+	prog.run<SPlanes64>(&regs[0]);
+
+	for (int t = 0; t < 64; ++t)
+	{
+		NBMatrix::TBArray<M> x;
+		for (int j = 0; j < M; ++j)
+			x[j] = ((regs[prog.get_in_base() + j] >> t) & 1) != 0;
+
+		const NBMatrix::TBArray<N> y = m * x;
+		for (int i = 0; i < rows; ++i)
 		{
-			printf_s("ENCR_DECR_SAVE_LOAD ERROR!!!\n");
+			if (y[i] != (uint8_t)((regs[prog.get_out_base() + i] >> t) & 1))
+				return false;
 		}
-		else
-		{
-			printf_s("ENCR_DECR_SAVE_LOAD OK!!!\n");
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_xor_program()
+//
+// Check XOR programs of both inverse matrices against matrix multiplication
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_xor_program()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	// Mix rows of the second matrix are not used by bit-sliced decryption
+	bool ok = check_xor_program(d->get_inv_bmtrx1(), CEncryption::bit_size1) &&
+		check_xor_program(d->get_inv_bmtrx2(), CEncryption::bit_size2) &&
+		check_xor_program(d->get_inv_bmtrx2(), CEncryption::bit_size1);
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+static int get_hex_digit(char c)
+{
+	return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+}
+
+// Compare len bytes with a hex string
+static bool is_hex(const uint8_t* data, size_t len, const char* hex)
+{
+	for (size_t i = 0; i < len; ++i)
+	{
+		if (data[i] != ((get_hex_digit(hex[i << 1]) << 4) | get_hex_digit(hex[(i << 1) + 1])))
+			return false;
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_sha256()
+//
+// Check SHA-256 with FIPS 180-4 examples one-shot and by parts, check 8-lane hashing
+// and suffix hashes against one-shot hashing
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_sha256()
+{
+	static const char two_blocks[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+	static const char empty_hex[] = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+	static const char abc_hex[] = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	static const char two_blocks_hex[] = "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1";
+	static const char million_a_hex[] = "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0";
+
+	const size_t two_blocks_len = sizeof(two_blocks) - 1;
+
+	uint8_t digest[NSha256::digest_size];
+	uint8_t digests[NSha256::lanes_num * NSha256::digest_size];
+
+	// One-shot
+	NSha256::sha256("", 0, digest);
+	bool ok = is_hex(digest, sizeof(digest), empty_hex);
+
+	NSha256::sha256("abc", 3, digest);
+	ok = ok && is_hex(digest, sizeof(digest), abc_hex);
+
+	NSha256::sha256(two_blocks, two_blocks_len, digest);
+	ok = ok && is_hex(digest, sizeof(digest), two_blocks_hex);
+
+	// By parts of different sizes (up to 997 bytes), so parts cross block boundaries in different ways
+	uint8_t a[1000];
+	memset(a, 'a', sizeof(a));
+
+	NSha256::CSha256 h;
+	size_t left = 1000000;
+	for (size_t part = 1; left; part = part % 991 + 7)
+	{
+		size_t cnt = part < left ? part : left;
+		h.update(a, cnt);
+		left -= cnt;
+	}
+	h.final(digest);
+	ok = ok && is_hex(digest, sizeof(digest), million_a_hex);
+
+	// 8 lanes
+	const uint8_t* msgs[NSha256::lanes_num];
+	uint8_t lanes[NSha256::lanes_num][sizeof(two_blocks)];
+
+	for (int j = 0; j < NSha256::lanes_num; ++j)
+		msgs[j] = (const uint8_t*)"abc";
+
+	NSha256::sha256_x8(msgs, 3, digests);
+	for (int j = 0; j < NSha256::lanes_num; ++j)
+		ok = ok && is_hex(digests + j * NSha256::digest_size, NSha256::digest_size, abc_hex);
+
+	for (int j = 0; j < NSha256::lanes_num; ++j)
+	{
+		memcpy(lanes[j], two_blocks, two_blocks_len);
+		lanes[j][j] ^= 1;
+		msgs[j] = lanes[j];
+	}
+
+	NSha256::sha256_x8(msgs, two_blocks_len, digests);
+	for (int j = 0; j < NSha256::lanes_num; ++j)
+	{
+		NSha256::sha256(lanes[j], two_blocks_len, digest);
+		ok = ok && !memcmp(digest, digests + j * NSha256::digest_size, NSha256::digest_size);
+	}
+
+	// Suffix hashes of one prefix and of different prefixes
+	uint8_t blocks[NSha256::lanes_num][NSha256::CSuffixHash::msg_len];
+	NSha256::CSuffixHash* hashes[NSha256::lanes_num];
+	uint64_t suffixes[NSha256::lanes_num];
+
+	NPrng::get_rnd(blocks, sizeof(blocks));
+
+	const uint64_t first = 0xfedcba9876543210ull;
+	NSha256::CSuffixHash sh(blocks[0]);
+	sh.hash_x8(first, digests);
+
+	for (int j = 0; j < NSha256::lanes_num; ++j)
+	{
+		uint8_t block[NSha256::CSuffixHash::msg_len];
+		memcpy(block, blocks[0], NSha256::CSuffixHash::prefix_size);
+		for (int i = 0; i < 8; ++i)
+			block[NSha256::CSuffixHash::prefix_size + i] = (uint8_t)((first + j) >> (i << 3));
+
+		NSha256::sha256(block, sizeof(block), digest);
+		ok = ok && !memcmp(digest, digests + j * NSha256::digest_size, NSha256::digest_size);
+
+		sh.hash(first + j, digest);
+		ok = ok && !memcmp(digest, digests + j * NSha256::digest_size, NSha256::digest_size);
+	}
+
+	for (int j = 0; j < NSha256::lanes_num; ++j)
+	{
+		hashes[j] = new NSha256::CSuffixHash(blocks[j]);
+		suffixes[j] = 0;
+		for (int i = 0; i < 8; ++i)
+			suffixes[j] |= (uint64_t)blocks[j][NSha256::CSuffixHash::prefix_size + i] << (i << 3);
+	}
+
+	NSha256::CSuffixHash::hash_x8(hashes, suffixes, digests);
+	for (int j = 0; j < NSha256::lanes_num; ++j)
+	{
+		NSha256::sha256(blocks[j], sizeof(blocks[j]), digest);
+		ok = ok && !memcmp(digest, digests + j * NSha256::digest_size, NSha256::digest_size);
+
+		delete hashes[j];
+	}
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_shake256()
+//
+// Check SHAKE256 with known answers (one of them is longer than a block of input and
+// of output), check that squeezing by parts gives the one-shot output
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_shake256()
+{
+	static const char empty_hex[] = "46b9dd2b0ba88d13233b3feb743eeb243fcd52ea62b81b82b50c27646ed5762f";
+	static const char abc_hex[] = "483366601360a8771c6863080cc4114d8db44530f8f1e1ee4f94ea37e78b5739";
+	// 200 bytes 0xa3, first 64 bytes of the output
+	static const char a3_hex[] = "cd8a920ed141aa0407a22d59288652e9d9f1a7ee0c1e7c1ca699424da84a904d"
+		"2d700caae7396ece96604440577da4f3aa22aeb8857f961c4cd8e06f0ae6610b";
+
+	uint8_t out[32];
+	uint8_t a3[200];
+	uint8_t one_shot[3 * NShake::rate + 5];
+	uint8_t parts[sizeof(one_shot)];
+
+	NShake::shake256("", 0, out, sizeof(out));
+	bool ok = is_hex(out, sizeof(out), empty_hex);
+
+	NShake::shake256("abc", 3, out, sizeof(out));
+	ok = ok && is_hex(out, sizeof(out), abc_hex);
+
+	memset(a3, 0xa3, sizeof(a3));
+	NShake::shake256(a3, sizeof(a3), one_shot, sizeof(one_shot));
+	ok = ok && is_hex(one_shot, 64, a3_hex);
+
+	// Input and output by parts of different sizes, so parts cross block boundaries
+	NShake::CShake256 h;
+	for (size_t pos = 0, part = 1; pos < sizeof(a3); pos += part, part = part * 3 + 1)
+		h.update(a3 + pos, part < sizeof(a3) - pos ? part : sizeof(a3) - pos);
+
+	for (size_t pos = 0, part = 1; pos < sizeof(parts); pos += part, part = part * 2 + 3)
+		h.squeeze(parts + pos, part < sizeof(parts) - pos ? part : sizeof(parts) - pos);
+
+	ok = ok && !memcmp(one_shot, parts, sizeof(parts));
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_sign_xof()
+//
+// Sign a message with SHAKE256 candidates, verify the signature, check that a changed
+// message or index is rejected and that a nonzero index is rejected by signatures
+// with SHA-256 candidates
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_sign_xof()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	NExec::CExecutor exec;
+	NSign::CSignKey key(CPrivKey(*d), e->get_comb_tbxs());
+	const pub_key &pub = e->get_comb_tbxs();
+
+	const uint8_t *data = (const uint8_t*)msg;
+	NSign::SSignature sig;
+
+	bool ok = NSign::sign_xof(key, data, sizeof(msg), sig, exec);
+	ok = ok && sig.index < NSign::xof_cands_num && NSign::verify_xof(pub, data, sizeof(msg), sig);
+	ok = ok && !NSign::verify_xof(pub, data, sizeof(msg) - 1, sig);
+
+	// The deterministic search returns the same signature
+	NSign::SSignature sig2;
+	ok = ok && NSign::sign_xof(key, data, sizeof(msg), sig2, exec);
+	ok = ok && sig2.counter == sig.counter && sig2.index == sig.index && !memcmp(sig2.body, sig.body, sizeof(sig.body));
+
+	for (int i = 0; ok && i < 256; ++i)
+	{
+		if (i == sig.index)
+			continue;
+
+		sig2.index = (uint8_t)i;
+		ok = !NSign::verify_xof(pub, data, sizeof(msg), sig2);
+	}
+
+	// Candidates of sign and sign_document have no index
+	ok = ok && NSign::sign(key, data, sizeof(msg), sig, exec);
+	ok = ok && NSign::verify(pub, data, sizeof(msg), sig);
+	sig.index = 1;
+	ok = ok && !NSign::verify(pub, data, sizeof(msg), sig);
+
+	ok = ok && NSign::sign_document(key, data, sizeof(msg), sig, exec);
+	ok = ok && NSign::verify_document(pub, data, sizeof(msg), sig);
+	sig.index = 1;
+	ok = ok && !NSign::verify_document(pub, data, sizeof(msg), sig);
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_sign_merkle()
+//
+// Sign batches of one message and of a number of messages that is not a power of two,
+// verify every signature, check that a wrong message, leaf, path node or number of
+// leaves is rejected. A signature of the maximum depth is built for a batch of equal
+// messages (all nodes of a level are equal) and checked the same way
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_sign_merkle()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	NExec::CExecutor exec;
+	NSign::CSignKey key(CPrivKey(*d), e->get_comb_tbxs());
+	const pub_key &pub = e->get_comb_tbxs();
+
+	const size_t max_n = 13;
+	uint8_t hashes[max_n][NSign::hash_size];
+	NSign::SMerkleSignature *sigs = new NSign::SMerkleSignature[max_n];
+
+	NPrng::get_rnd(hashes, sizeof(hashes));
+
+	bool ok = !NSign::sign_merkle(key, hashes[0], 0, sigs, exec);
+	ok = ok && !NSign::sign_merkle(key, hashes[0], ((size_t)1 << NSign::merkle_max_depth) + 1, sigs, exec);
+
+	// 13 leaves: the last one goes up without a pair to the third level
+	static const size_t nums[] = { 1, max_n };
+	static const int depths[] = { 0, 4 };
+
+	for (int t = 0; ok && t < 2; ++t)
+	{
+		size_t n = nums[t];
+		ok = NSign::sign_merkle(key, hashes[0], n, sigs, exec);
+
+		for (size_t i = 0; ok && i < n; ++i)
+		{
+			NSign::SMerkleSignature sig = sigs[i];
+
+			ok = sig.leaf == i && sig.leaves_num == n && NSign::verify_merkle(pub, hashes[i], sig);
+			ok = ok && (i == n - 1 && n > 1 ? sig.depth == 2 : sig.depth == depths[t]);
+			ok = ok && !NSign::verify_merkle(pub, hashes[(i + 1) % max_n], sig);
+
+			sig.leaf = (uint32_t)((i + 1) % n);
+			ok = ok && (n == 1 || !NSign::verify_merkle(pub, hashes[i], sig));
+			sig.leaf = (uint32_t)i;
+
+			sig.leaves_num = (uint32_t)(n + 1);
+			ok = ok && !NSign::verify_merkle(pub, hashes[i], sig);
+			sig.leaves_num = (uint32_t)(n - 1);
+			ok = ok && !NSign::verify_merkle(pub, hashes[i], sig);
+			sig.leaves_num = (uint32_t)n;
+
+			for (int l = 0; ok && l < sig.depth; ++l)
+			{
+				sig.path[l][l] ^= 1;
+				ok = !NSign::verify_merkle(pub, hashes[i], sig);
+				sig.path[l][l] ^= 1;
+			}
+
+			++sig.depth;
+			ok = ok && !NSign::verify_merkle(pub, hashes[i], sig);
+			--sig.depth;
+
+			ok = ok && NSign::verify_merkle(pub, hashes[i], sig);
+		}
+	}
+
+	// The maximum depth. Nodes are hashed as sign_merkle does, the root digest
+	// is SHA-256 of the item below, so its signature is the one of sign_document
+	NSign::SMerkleSignature &sig = sigs[0];
+	const uint32_t leaves_num = (uint32_t)1 << NSign::merkle_max_depth;
+
+	uint8_t item[1 + 2 * NSign::hash_size];
+	uint8_t node[NSign::hash_size];
+
+	item[0] = 0;
+	memcpy(item + 1, hashes[0], NSign::hash_size);
+	NSha256::sha256(item, 1 + NSign::hash_size, node);
+
+	for (int l = 0; l < NSign::merkle_max_depth; ++l)
+	{
+		memcpy(sig.path[l], node, NSign::hash_size);
+
+		item[0] = 1;
+		memcpy(item + 1, node, NSign::hash_size);
+		memcpy(item + 1 + NSign::hash_size, node, NSign::hash_size);
+		NSha256::sha256(item, sizeof(item), node);
+	}
+
+	item[0] = 2;
+	memcpy(item + 1, node, NSign::hash_size);
+	for (int i = 0; i < 4; ++i)
+		item[1 + NSign::hash_size + i] = (uint8_t)(leaves_num >> (i << 3));
+
+	ok = ok && NSign::sign_document(key, item, 1 + NSign::hash_size + 4, sig.root, exec);
+
+	sig.leaf = 0x5a5a5;
+	sig.leaves_num = leaves_num;
+	sig.depth = NSign::merkle_max_depth;
+
+	ok = ok && NSign::verify_merkle(pub, hashes[0], sig);
+	ok = ok && !NSign::verify_merkle(pub, hashes[1], sig);
+
+	sig.leaf = leaves_num;
+	ok = ok && !NSign::verify_merkle(pub, hashes[0], sig);
+	sig.leaf = leaves_num - 1;
+	ok = ok && NSign::verify_merkle(pub, hashes[0], sig);
+
+	sig.path[NSign::merkle_max_depth - 1][0] ^= 1;
+	ok = ok && !NSign::verify_merkle(pub, hashes[0], sig);
+	sig.path[NSign::merkle_max_depth - 1][0] ^= 1;
+
+	// A tree with one more leaf is deeper than allowed
+	sig.leaves_num = leaves_num + 1;
+	ok = ok && !NSign::verify_merkle(pub, hashes[0], sig);
+
+	delete[] sigs;
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_sign_async()
+//
+// Sign a message and a document asynchronously, check that the signatures are the ones
+// of synchronous signing. Check that a search with a deadline is stopped in time while
+// other searches are queued and running, and that cancelled searches are stopped
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_sign_async()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	CEncryption *e2 = new CEncryption();
+	e2->gen_key();
+
+	const pub_key &pub = e->get_comb_tbxs();
+	const uint8_t *data = (const uint8_t*)msg;
+
+	NSign::CSignKey key(CPrivKey(*d), pub);
+	// Keys of different pairs, no candidate is valid, so a search runs until it is stopped
+	NSign::CSignKey bad(CPrivKey(*d), e2->get_comb_tbxs());
+	NSign::CCancelToken token;
+
+	bool ok = true;
+	{
+		NExec::CExecutor exec(2);
+		NSign::SSignature sig;
+
+		ok = NSign::sign(key, data, sizeof(msg), sig, exec);
+		NSign::SSignResult r = NSign::sign_async(key, data, sizeof(msg), exec).get();
+		ok = ok && r.status == NSign::sign_done && r.sig.counter == sig.counter && NSign::verify(pub, data, sizeof(msg), r.sig);
+
+		ok = ok && NSign::sign_document(key, data, sizeof(msg), sig, exec);
+		r = NSign::sign_document_async(key, data, sizeof(msg), exec).get();
+		ok = ok && r.status == NSign::sign_done && r.sig.counter == sig.counter && NSign::verify_document(pub, data, sizeof(msg), r.sig);
+
+		// The search with a deadline goes first, more searches than workers follow
+		NSign::SSignLimits timed_limits;
+		timed_limits.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+
+		NSign::SSignLimits busy_limits;
+		busy_limits.cancel = &token;
+
+		std::future<NSign::SSignResult> timed(NSign::sign_document_async(bad, data, sizeof(msg), exec, timed_limits));
+		std::vector<std::future<NSign::SSignResult> > busy;
+		for (int i = 0; i < 4; ++i)
+			busy.push_back(NSign::sign_document_async(bad, data, i + 1, exec, busy_limits));
+
+		ok = ok && timed.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+		for (size_t i = 0; i < busy.size(); ++i)
+			ok = ok && busy[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+
+		token.cancel();
+
+		r = timed.get();
+		ok = ok && r.status == NSign::sign_timeout && r.stats.elapsed < 5;
+
+		for (size_t i = 0; i < busy.size(); ++i)
+			ok = busy[i].get().status == NSign::sign_cancelled && ok;
+	}
+
+	// The executor is destroyed while the search is queued, the search still gives its result
+	std::future<NSign::SSignResult> f;
+	{
+		NExec::CExecutor one(1);
+		f = NSign::sign_async(key, data, sizeof(msg), one);
+	}
+
+	try
+	{
+		NSign::SSignResult r = f.get();
+		ok = ok && r.status == NSign::sign_done && NSign::verify(pub, data, sizeof(msg), r.sig);
+	}
+	catch (const std::future_error&)
+	{
+		ok = false;
+	}
+
+	delete e2;
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_verify_batch()
+//
+// Verify a batch of valid and broken document signatures (forged bodies, wrong counters,
+// sizes of counters, indexes and documents) and compare every result with verify_document.
+// Batches of sizes which are not multiples of 8 are checked too
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_verify_batch()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	NExec::CExecutor exec;
+	NSign::CSignKey key(CPrivKey(*d), e->get_comb_tbxs());
+	const pub_key &pub = e->get_comb_tbxs();
+
+	enum
+	{
+		docs_num = 5,
+		doc_size = 48,
+		max_n = 37,
+		kinds_num = 9
+	};
+
+	uint8_t docs[docs_num][doc_size];
+	uint8_t doc_hashes[docs_num][NSign::hash_size];
+	NSign::SSignature doc_sigs[docs_num];
+
+	NPrng::get_rnd(docs, sizeof(docs));
+
+	bool ok = true;
+	for (int k = 0; ok && k < docs_num; ++k)
+	{
+		NSha256::sha256(docs[k], doc_size, doc_hashes[k]);
+		ok = NSign::sign_document(key, docs[k], doc_size, doc_sigs[k], exec);
+	}
+
+	// Signature i is the one of document i % docs_num, broken the way i % kinds_num says
+	uint8_t hashes[max_n][NSign::hash_size];
+	NSign::SSignature sigs[max_n];
+	const uint8_t *data[max_n];
+	bool valid[max_n];
+
+	for (int i = 0; i < max_n; ++i)
+	{
+		int k = i % docs_num;
+		NSign::SSignature &sig = sigs[i];
+
+		sig = doc_sigs[k];
+		data[i] = docs[k];
+		valid[i] = false;
+
+		switch (i % kinds_num)
+		{
+		case 1:
+			sig.body[i % msg_size] ^= 1 << (i & 7);
+			break;
+		case 2:
+			++sig.counter;
+			break;
+		case 3:
+			sig.counter_size = NSign::default_counter_size;
+			break;
+		case 4:
+			sig.index = 1;
+			break;
+		case 5:
+			data[i] = docs[(k + 1) % docs_num];
+			break;
+		case 6:
+			sig.counter = ~(uint64_t)0;
+			break;
+		case 7:
+			sig.body[msg_size - 1] ^= 0x80;
+			break;
+		default:
+			valid[i] = true;
+			break;
+		}
+
+		NSha256::sha256(data[i], doc_size, hashes[i]);
+	}
+
+	static const size_t nums[] = { 1, 7, 8, 9, 16, 30, max_n };
+
+	for (size_t t = 0; ok && t < sizeof(nums) / sizeof(nums[0]); ++t)
+	{
+		bool results[max_n];
+		memset(results, 0, sizeof(results));
+
+		NSign::verify_batch(pub, sigs, hashes[0], nums[t], results);
+
+		for (size_t i = 0; ok && i < nums[t]; ++i)
+			ok = results[i] == valid[i] && results[i] == NSign::verify_document(pub, data[i], doc_size, sigs[i]);
+	}
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_sign_many()
+//
+// Sign documents given by their hashes at once, check that each is counted once in the
+// attempts histogram, verify the signatures one by one and as a batch, check that
+// a signature of another document is rejected
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_sign_many()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	NExec::CExecutor exec;
+	NSign::CSignKey key(CPrivKey(*d), e->get_comb_tbxs());
+	const pub_key &pub = e->get_comb_tbxs();
+
+	// The number of documents is not a multiple of 8, so lanes move between documents
+	enum
+	{
+		docs_num = 21,
+		doc_size = 40
+	};
+
+	uint8_t docs[docs_num][doc_size];
+	uint8_t hashes[docs_num][NSign::hash_size];
+	NSign::SSignature sigs[docs_num];
+	bool results[docs_num];
+
+	NPrng::get_rnd(docs, sizeof(docs));
+	for (int i = 0; i < docs_num; ++i)
+		NSha256::sha256(docs[i], doc_size, hashes[i]);
+
+	NSign::reset_attempts_histogram();
+
+	bool ok = NSign::sign_many(key, hashes[0], docs_num, sigs, exec);
+
+	// Every signed document is counted once
+	uint64_t counts[NSign::histogram_size];
+	NSign::get_attempts_histogram(counts);
+	uint64_t total(0);
+	for (int i = 0; i < NSign::histogram_size; ++i)
+		total += counts[i];
+
+	ok = ok && total == docs_num;
+
+	NSign::reset_attempts_histogram();
+
+	for (int i = 0; ok && i < docs_num; ++i)
+	{
+		ok = NSign::verify_document(pub, docs[i], doc_size, sigs[i]);
+		ok = ok && !NSign::verify_document(pub, docs[(i + 1) % docs_num], doc_size, sigs[i]);
+	}
+
+	memset(results, 0, sizeof(results));
+	NSign::verify_batch(pub, sigs, hashes[0], docs_num, results);
+	for (int i = 0; ok && i < docs_num; ++i)
+		ok = results[i];
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+//
+// Decrypt len bytes by parts of part bytes (all at once if part is 0), out_len bytes are written
+//
+static bool decrypt_stream(CStreamDecryptor& dcr, const uint8_t* in, size_t len, size_t part, uint8_t* out, size_t out_size,
+	size_t& out_len)
+{
+	size_t written;
+
+	dcr.reset();
+	out_len = 0;
+
+	for (size_t pos = 0; pos < len; pos += part)
+	{
+		if (!part || part > len - pos)
+			part = len - pos;
+
+		if (!dcr.update(in + pos, part, out + out_len, out_size - out_len, written))
+			return false;
+		out_len += written;
+	}
+
+	if (!dcr.final(out + out_len, out_size - out_len, written))
+		return false;
+	out_len += written;
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_stream()
+//
+// Encrypt messages of different lengths by parts of odd sizes, decrypt them at once and
+// by parts, check that truncated cipher texts and wrong padding are rejected
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_stream()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	const pub_key &pub = e->get_comb_tbxs();
+
+	enum
+	{
+		max_len = 1000
+	};
+
+	// Bytes of messages are not values of padding, so a cut message never looks padded
+	uint8_t src[max_len];
+	NPrng::get_rnd(src, sizeof(src));
+	for (size_t i = 0; i < max_len; ++i)
+		src[i] |= 0x40;
+
+	std::vector<uint8_t> crpt(CStreamEncryptor::get_crypt_size(max_len));
+	uint8_t dst[max_len + msg_size];
+	uint8_t block[msg_size];
+
+	CPrivKey prv(*d);
+	CStreamEncryptor enc(pub);
+	CStreamDecryptor dcr(prv);
+
+	static const size_t lens[] = { 0, 1, 31, 32, 33, max_len };
+
+	bool ok = true;
+	for (size_t t = 0; ok && t < sizeof(lens) / sizeof(lens[0]); ++t)
+	{
+		size_t len = lens[t];
+		size_t crpt_len = 0;
+		size_t dst_len;
+		size_t written;
+
+		enc.reset();
+		for (size_t pos = 0, part = 1; ok && pos < len; pos += part, part += 2)
+		{
+			size_t cnt = part < len - pos ? part : len - pos;
+			size_t max_written = enc.get_update_size(cnt);
+			ok = enc.update(src + pos, cnt, &crpt[crpt_len], crpt.size() - crpt_len, written) && written <= max_written;
+			crpt_len += written;
+		}
+
+		ok = ok && enc.final(&crpt[crpt_len], crpt.size() - crpt_len, written);
+		crpt_len += written;
+
+		// There is always a padded block, so the cipher text is a whole number of blocks
+		ok = ok && crpt_len == CStreamEncryptor::get_crypt_size(len) && crpt_len == (len / msg_size + 1) * crpt_size;
+
+		static const size_t parts[] = { 0, 1, 7, crpt_size, crpt_size + 3 };
+		for (size_t p = 0; ok && p < sizeof(parts) / sizeof(parts[0]); ++p)
+			ok = decrypt_stream(dcr, &crpt[0], crpt_len, parts[p], dst, sizeof(dst), dst_len) && dst_len == len && !memcmp(dst, src, len);
+
+		// Truncated by a byte and by a block
+		ok = ok && !decrypt_stream(dcr, &crpt[0], crpt_len - 1, 0, dst, sizeof(dst), dst_len);
+		ok = ok && !decrypt_stream(dcr, &crpt[0], crpt_len - crpt_size, 5, dst, sizeof(dst), dst_len);
+
+		// The padded block is replaced by blocks with wrong padding
+		uint8_t *last = &crpt[crpt_len - crpt_size];
+		size_t pad = msg_size - len % msg_size;
+
+		memcpy(block, src + len - len % msg_size, len % msg_size);
+		memset(block + len % msg_size, (int)pad, pad);
+
+		encrypt(pub, block, last);
+		ok = ok && decrypt_stream(dcr, &crpt[0], crpt_len, 0, dst, sizeof(dst), dst_len) && dst_len == len;
+
+		static const uint8_t wrong_pads[] = { 0, msg_size + 1, 0xff };
+		for (size_t w = 0; ok && w < sizeof(wrong_pads); ++w)
+		{
+			block[msg_size - 1] = wrong_pads[w];
+			encrypt(pub, block, last);
+			ok = !decrypt_stream(dcr, &crpt[0], crpt_len, 0, dst, sizeof(dst), dst_len);
+		}
+
+		// A padding byte differs from the last one
+		if (ok && pad > 1)
+		{
+			block[msg_size - 1] = (uint8_t)pad;
+			block[msg_size - pad] ^= 1;
+			encrypt(pub, block, last);
+			ok = !decrypt_stream(dcr, &crpt[0], crpt_len, 0, dst, sizeof(dst), dst_len);
+		}
+	}
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_partial()
+//
+// Encrypt messages with fixed bytes one by one and in batches of odd sizes, compare with
+// encryption of the messages whose fixed bytes are replaced by the fixed ones
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_partial()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	const pub_key &pub = e->get_comb_tbxs();
+
+	enum
+	{
+		max_n = 33
+	};
+
+	uint8_t fixed[msg_size];
+	uint8_t msgs[max_n][msg_size];
+	uint8_t full[max_n][msg_size];
+	uint8_t expected[max_n][crpt_size];
+	uint8_t crpts[max_n][crpt_size];
+
+	uint32_t masks[] = { 0, 0xffffffff, 0x0000ffff, 0x80000001, 0 };
+	NPrng::get_rnd(&masks[4], sizeof(masks[4]));
+
+	static const size_t nums[] = { 1, 3, 5, 7, max_n };
+
+	bool ok = true;
+	for (size_t m = 0; ok && m < sizeof(masks) / sizeof(masks[0]); ++m)
+	{
+		NPrng::get_rnd(fixed, sizeof(fixed));
+		NPrng::get_rnd(msgs, sizeof(msgs));
+
+		CPartialKey key(pub, masks[m], fixed);
+		ok = key.get_mask() == masks[m];
+
+		for (int i = 0; i < max_n; ++i)
+		{
+			for (int j = 0; j < msg_size; ++j)
+				full[i][j] = (masks[m] >> j) & 1 ? fixed[j] : msgs[i][j];
+
+			encrypt(pub, full[i], expected[i]);
+		}
+
+		for (int i = 0; ok && i < max_n; ++i)
+		{
+			key.encrypt(msgs[i], crpts[i]);
+			ok = !memcmp(crpts[i], expected[i], crpt_size);
+		}
+
+		for (size_t t = 0; ok && t < sizeof(nums) / sizeof(nums[0]); ++t)
+		{
+			memset(crpts, 0, sizeof(crpts));
+			key.encrypt_batch(msgs[0], nums[t], crpts[0]);
+			ok = !memcmp(crpts, expected, nums[t] * crpt_size);
+		}
+	}
+
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_update_ciphertext()
+//
+// Change 1 .. msg_size bytes of a message, update its cipher text byte by byte and
+// by the whole message, compare with encryption of the new message
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_update_ciphertext()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	const pub_key &pub = e->get_comb_tbxs();
+
+	uint8_t old_msg[msg_size];
+	uint8_t new_msg[msg_size];
+	uint8_t perm[msg_size];
+	uint8_t expected[crpt_size];
+	uint8_t crpt1[crpt_size];
+	uint8_t crpt2[crpt_size];
+
+	for (int i = 0; i < msg_size; ++i)
+		perm[i] = (uint8_t)i;
+
+	bool ok = true;
+	for (int n = 1; ok && n <= msg_size; ++n)
+	{
+		NPrng::get_rnd(old_msg, sizeof(old_msg));
+		memcpy(new_msg, old_msg, sizeof(new_msg));
+
+		// n different positions, every value is changed
+		for (int i = 0; i < n; ++i)
+		{
+			uint8_t r[2];
+			NPrng::get_rnd(r, sizeof(r));
+
+			int j = i + r[0] % (msg_size - i);
+			uint8_t t = perm[i];
+			perm[i] = perm[j];
+			perm[j] = t;
+
+			new_msg[perm[i]] ^= r[1] | 1;
+		}
+
+		encrypt(pub, old_msg, crpt1);
+		memcpy(crpt2, crpt1, crpt_size);
+		encrypt(pub, new_msg, expected);
+
+		for (int i = 0; i < n; ++i)
+			update_ciphertext(pub, crpt1, perm[i], old_msg[perm[i]], new_msg[perm[i]]);
+
+		update_ciphertext(pub, crpt2, old_msg, new_msg);
+
+		ok = !memcmp(crpt1, expected, crpt_size) && !memcmp(crpt2, expected, crpt_size);
+	}
+
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_rebase()
+//
+// Encrypt and decrypt with rebased tables one by one and in batches, compare with
+// batch functions of the original tables. Messages and cipher texts are all zero,
+// mostly zero or random, so rows of zero bytes are skipped in different ways
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_rebase()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	const pub_key &pub = e->get_comb_tbxs();
+	CPrivKey prv(*d);
+
+	CRebasedPubKey *rpub = new CRebasedPubKey(pub);
+	CRebasedPrivKey *rprv = new CRebasedPrivKey(prv);
+
+	enum
+	{
+		max_n = 9
+	};
+
+	uint8_t msgs[max_n][msg_size];
+	uint8_t crpts[max_n][crpt_size];
+	uint8_t expected_crpts[max_n][crpt_size];
+	uint8_t expected_msgs[max_n][msg_size];
+	uint8_t out_crpts[max_n][crpt_size];
+	uint8_t out_msgs[max_n][msg_size];
+
+	static const size_t nums[] = { 1, 4, 5, max_n };
+
+	bool ok = true;
+	for (int t = 0; ok && t < 3; ++t)
+	{
+		// t = 0: all zero, t = 1: about one byte of eight is not zero, t = 2: random
+		NPrng::get_rnd(msgs, sizeof(msgs));
+		NPrng::get_rnd(crpts, sizeof(crpts));
+
+		for (int i = 0; i < max_n; ++i)
+		{
+			for (int j = 0; j < crpt_size; ++j)
+			{
+				if (!t || (t == 1 && (crpts[i][j] & 7)))
+					crpts[i][j] = 0;
+				if (j < msg_size && (!t || (t == 1 && (msgs[i][j] & 7))))
+					msgs[i][j] = 0;
+			}
+		}
+
+		// A cipher text of a mostly zero message too
+		encrypt(pub, msgs[0], crpts[max_n - 1]);
+
+		encrypt_batch(pub, msgs[0], max_n, expected_crpts[0]);
+		decrypt_batch(prv, crpts[0], max_n, expected_msgs[0]);
+
+		for (int i = 0; ok && i < max_n; ++i)
+		{
+			rpub->encrypt(msgs[i], out_crpts[i]);
+			rprv->decrypt(crpts[i], out_msgs[i]);
+
+			ok = !memcmp(out_crpts[i], expected_crpts[i], crpt_size) && !memcmp(out_msgs[i], expected_msgs[i], msg_size);
+		}
+
+		ok = ok && !memcmp(out_msgs[max_n - 1], msgs[0], msg_size);
+
+		for (size_t k = 0; ok && k < sizeof(nums) / sizeof(nums[0]); ++k)
+		{
+			memset(out_crpts, 0, sizeof(out_crpts));
+			memset(out_msgs, 0, sizeof(out_msgs));
+
+			rpub->encrypt_batch(msgs[0], nums[k], out_crpts[0]);
+			rprv->decrypt_batch(crpts[0], nums[k], out_msgs[0]);
+
+			ok = !memcmp(out_crpts, expected_crpts, nums[k] * crpt_size) && !memcmp(out_msgs, expected_msgs, nums[k] * msg_size);
+		}
+	}
+
+	delete rprv;
+	delete rpub;
+
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_encr_multi()
+//
+// Encrypt a message for many recipients (keys repeat, their number is not a multiple
+// of the grain) serially and in parallel, compare with encryption by every key
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_encr_multi()
+{
+	enum
+	{
+		pairs_num = 3,
+		max_keys = 2 * multi_grain + 5
+	};
+
+	CEncryption *es[pairs_num];
+	for (int k = 0; k < pairs_num; ++k)
+	{
+		es[k] = new CEncryption();
+		es[k]->gen_key();
+	}
+
+	const pub_key *keys[max_keys];
+	for (int i = 0; i < max_keys; ++i)
+		keys[i] = &es[(i * i) % pairs_num]->get_comb_tbxs();
+
+	NExec::CExecutor exec;
+	uint8_t crpts[max_keys][crpt_size];
+	uint8_t expected[crpt_size];
+
+	static const size_t nums[] = { 1, multi_grain - 1, multi_grain + 1, max_keys };
+
+	bool ok = true;
+	for (size_t t = 0; ok && t < sizeof(nums) / sizeof(nums[0]); ++t)
+	{
+		for (int p = 0; ok && p < 2; ++p)
+		{
+			memset(crpts, 0, sizeof(crpts));
+
+			if (p)
+				encrypt_multi_parallel(exec, keys, nums[t], (const uint8_t*)msg, crpts[0]);
+			else
+				encrypt_multi(keys, nums[t], (const uint8_t*)msg, crpts[0]);
+
+			for (size_t i = 0; ok && i < nums[t]; ++i)
+			{
+				encrypt(*keys[i], (const uint8_t*)msg, expected);
+				ok = !memcmp(crpts[i], expected, crpt_size);
+			}
+		}
+	}
+
+	for (int k = 0; k < pairs_num; ++k)
+		delete es[k];
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_nibble_geometry()
+//
+// Decrypt with tables indexed by nibbles and by bytes, compare with each other and with
+// source messages, check that a copy keeps the geometry and that tables of the other
+// geometry are not given
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_nibble_geometry()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	CDecryption *nd = new CDecryption(*e);
+	bool ok = nd->init(CDecryption::nibble_geometry) && nd->get_geometry() == CDecryption::nibble_geometry;
+
+	CDecryption *copy = new CDecryption(*nd);
+	ok = ok && copy->get_geometry() == CDecryption::nibble_geometry && d->get_geometry() == CDecryption::byte_geometry;
+
+	uint8_t src[msg_size];
+	uint8_t crpt[crpt_size];
+	uint8_t t0[msg_size];
+	uint8_t t1[msg_size];
+	uint8_t t2[msg_size];
+
+	for (int t = 0; ok && t < 256; ++t)
+	{
+		NPrng::get_rnd(src, sizeof(src));
+		encrypt(e->get_comb_tbxs(), src, crpt);
+
+		// Every other cipher text is random
+		if (t & 1)
+			NPrng::get_rnd(crpt, sizeof(crpt));
+
+		d->decrypt(crpt, t0);
+		nd->decrypt(crpt, t1);
+		copy->decrypt(crpt, t2);
+
+		ok = !memcmp(t0, t1, msg_size) && !memcmp(t0, t2, msg_size) && ((t & 1) || !memcmp(t0, src, msg_size));
+	}
+
+	// Tables of the other geometry
+	int thrown = 0;
+	try
+	{
+		nd->get_inv_comb_tbxs2();
+	}
+	catch (const std::runtime_error&)
+	{
+		++thrown;
+	}
+
+	try
+	{
+		copy->get_final_tbxs();
+	}
+	catch (const std::runtime_error&)
+	{
+		++thrown;
+	}
+
+	try
+	{
+		d->get_inv_nibble_tbxs2();
+	}
+	catch (const std::runtime_error&)
+	{
+		++thrown;
+	}
+
+	ok = ok && thrown == 3;
+
+	delete copy;
+	delete nd;
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_matrix_decr()
+//
+// Decrypt valid and random cipher texts with inverse matrices, compare with decryption
+// by tables and with source messages
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_matrix_decr()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	CDecryption *d = new CDecryption(*e);
+	d->init();
+
+	CMatrixDecryption *md = new CMatrixDecryption(*d);
+
+	uint8_t src[msg_size];
+	uint8_t crpt[crpt_size];
+	uint8_t res0[msg_size];
+	uint8_t res1[msg_size];
+
+	bool ok = true;
+	for (int t = 0; ok && t < 1000; ++t)
+	{
+		NPrng::get_rnd(src, sizeof(src));
+		encrypt(e->get_comb_tbxs(), src, crpt);
+
+		// Every other cipher text is random
+		if (t & 1)
+			NPrng::get_rnd(crpt, sizeof(crpt));
+
+		d->decrypt(crpt, res0);
+		md->decrypt(crpt, res1);
+
+		ok = !memcmp(res0, res1, msg_size) && ((t & 1) || !memcmp(res1, src, msg_size));
+	}
+
+	delete md;
+	delete d;
+	delete e;
+
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// test_decr_checked()
+//
+// Decrypt with the validity check in byte and nibble geometry: valid cipher texts give
+// their messages, random ones and single-bit flips of valid ones are rejected.
+// An input is valid exactly if it is the encryption of its decryption, so rare random
+// inputs which pass are checked the same way
+/////////////////////////////////////////////////////////////////////////////////////////
+bool test_decr_checked()
+{
+	CEncryption *e = new CEncryption();
+	e->gen_key();
+
+	const pub_key &pub = e->get_comb_tbxs();
+
+	uint8_t src[msg_size];
+	uint8_t crpt[crpt_size];
+	uint8_t res[msg_size];
+	uint8_t check[crpt_size];
+
+	bool ok = true;
+	for (int g = 0; ok && g < 2; ++g)
+	{
+		CDecryption *d = new CDecryption(*e);
+		ok = d->init(g ? CDecryption::nibble_geometry : CDecryption::byte_geometry);
+
+		int accepted = 0;
+		int trials = 0;
+
+		for (int t = 0; ok && t < 16; ++t)
+		{
+			NPrng::get_rnd(src, sizeof(src));
+			encrypt(pub, src, crpt);
+
+			ok = d->decrypt_checked(crpt, res) && !memcmp(res, src, msg_size);
+
+			// Every bit of the cipher text is flipped in turn
+			for (int b = 0; ok && b < crpt_size * 8; ++b)
+			{
+				crpt[b >> 3] ^= 1 << (b & 7);
+
+				bool valid = d->decrypt_checked(crpt, res);
+				encrypt(pub, res, check);
+				ok = valid == !memcmp(check, crpt, crpt_size);
+
+				accepted += valid;
+				++trials;
+
+				crpt[b >> 3] ^= 1 << (b & 7);
+			}
+		}
+
+		for (int t = 0; ok && t < 4096; ++t)
+		{
+			NPrng::get_rnd(crpt, sizeof(crpt));
+
+			bool valid = d->decrypt_checked(crpt, res);
+			encrypt(pub, res, check);
+			ok = valid == !memcmp(check, crpt, crpt_size);
+
+			accepted += valid;
+			++trials;
+		}
+
+		// About one random input of 2^16 is valid
+		ok = ok && accepted * 1000 < trials;
+
+		delete d;
+	}
+
+	delete e;
+
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	for (;;)
+	{
+		if (!test_sign())
+		{
+			printf_s("SIGNATURE ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("SIGNATURE OK!!!\n");
+		}
+
+		if (!test_encr_decr())
+		{
+			printf_s("ENCR_DECR ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("ENCR_DECR OK!!!\n");
+		}
+
+		if (!test_encr_decr_save_load())
+		{
+			printf_s("ENCR_DECR_SAVE_LOAD ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("ENCR_DECR_SAVE_LOAD OK!!!\n");
+		}
+
+		if (!test_sign_parallel())
+		{
+			printf_s("SIGNATURE_PARALLEL ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("SIGNATURE_PARALLEL OK!!!\n");
+		}
+
+		if (!test_encr_decr_batch())
+		{
+			printf_s("ENCR_DECR_BATCH ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("ENCR_DECR_BATCH OK!!!\n");
+		}
+
+		if (!test_executor())
+		{
+			printf_s("EXECUTOR ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("EXECUTOR OK!!!\n");
+		}
+
+		if (!test_aead())
+		{
+			printf_s("AEAD ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("AEAD OK!!!\n");
+		}
+
+		if (!test_owner())
+		{
+			printf_s("OWNER ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("OWNER OK!!!\n");
+		}
+
+		if (!test_gfni_decr())
+		{
+			printf_s("GFNI_DECR ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("GFNI_DECR OK!!!\n");
+		}
+
+		if (!test_bitsliced_decr())
+		{
+			printf_s("BITSLICED_DECR ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("BITSLICED_DECR OK!!!\n");
+		}
+
+		if (!test_xor_program())
+		{
+			printf_s("XOR_PROGRAM ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("XOR_PROGRAM OK!!!\n");
+		}
+
+		if (!test_sha256())
+		{
+			printf_s("SHA256 ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("SHA256 OK!!!\n");
+		}
+
+		if (!test_shake256())
+		{
+			printf_s("SHAKE256 ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("SHAKE256 OK!!!\n");
+		}
+
+		if (!test_sign_xof())
+		{
+			printf_s("SIGNATURE_XOF ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("SIGNATURE_XOF OK!!!\n");
+		}
+
+		if (!test_sign_merkle())
+		{
+			printf_s("SIGNATURE_MERKLE ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("SIGNATURE_MERKLE OK!!!\n");
+		}
+
+		if (!test_sign_async())
+		{
+			printf_s("SIGNATURE_ASYNC ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("SIGNATURE_ASYNC OK!!!\n");
+		}
+
+		if (!test_verify_batch())
+		{
+			printf_s("VERIFY_BATCH ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("VERIFY_BATCH OK!!!\n");
+		}
+
+		if (!test_sign_many())
+		{
+			printf_s("SIGNATURE_MANY ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("SIGNATURE_MANY OK!!!\n");
+		}
+
+		if (!test_stream())
+		{
+			printf_s("STREAM ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("STREAM OK!!!\n");
+		}
+
+		if (!test_partial())
+		{
+			printf_s("PARTIAL ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("PARTIAL OK!!!\n");
+		}
+
+		if (!test_update_ciphertext())
+		{
+			printf_s("UPDATE_CIPHERTEXT ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("UPDATE_CIPHERTEXT OK!!!\n");
+		}
+
+		if (!test_rebase())
+		{
+			printf_s("REBASE ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("REBASE OK!!!\n");
+		}
+
+		if (!test_encr_multi())
+		{
+			printf_s("ENCR_MULTI ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("ENCR_MULTI OK!!!\n");
+		}
+
+		if (!test_nibble_geometry())
+		{
+			printf_s("NIBBLE_GEOMETRY ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("NIBBLE_GEOMETRY OK!!!\n");
+		}
+
+		if (!test_matrix_decr())
+		{
+			printf_s("MATRIX_DECR ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("MATRIX_DECR OK!!!\n");
+		}
+
+		if (!test_decr_checked())
+		{
+			printf_s("DECR_CHECKED ERROR!!!\n");
+		}
+		else
+		{
+			printf_s("DECR_CHECKED OK!!!\n");
 		}
 	}
 
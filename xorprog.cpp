@@ -0,0 +1,184 @@
+//***************************************************************************************
+// xorprog.cpp
+// Straight-line XOR programs for multiplication by binary matrices
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "xorprog.h"
+
+namespace NCrypt
+{
+
+int CXorProgram::get_regs_num() const
+{
+	return m_cols + m_rows + 1 + (1 << m_group);
+}
+
+int CXorProgram::get_in_base() const
+{
+	return 0;
+}
+
+int CXorProgram::get_out_base() const
+{
+	return m_cols;
+}
+
+int CXorProgram::get_zero_reg() const
+{
+	return m_cols + m_rows;
+}
+
+int CXorProgram::get_xor_count() const
+{
+	return m_xor_count;
+}
+
+int CXorProgram::get_group_size() const
+{
+	return m_group;
+}
+
+const std::vector<CXorProgram::SXorOp>& CXorProgram::get_ops() const
+{
+	return m_ops;
+}
+
+bool CXorProgram::get_bit(int row, int col) const
+{
+	return ((m_bits[row * m_qwords + (col >> 6)] >> (col & 63)) & 1) != 0;
+}
+
+static void add_op(std::vector<CXorProgram::SXorOp>& ops, int dst, int a, int b)
+{
+	CXorProgram::SXorOp op = { (uint16_t)dst, (uint16_t)a, (uint16_t)b };
+	ops.push_back(op);
+}
+
+//
+// Program with groups of k columns, returns the number of XORs
+//
+int CXorProgram::build(int k, std::vector<SXorOp>& ops) const
+{
+	int zero = get_zero_reg();
+	int tmp_base = zero + 1;
+	int xors(0);
+
+	std::vector<bool> started(m_rows, false);
+	std::vector<int> regs(1 << k);
+	std::vector<int> patterns(m_rows);
+
+	ops.clear();
+
+	for (int g = 0; g < m_cols; g += k)
+	{
+		int w = m_cols - g < k ? m_cols - g : k;
+
+		// Register holding XOR of subset s of the group, -1 if it is not computed yet
+		for (int s = 0; s < (1 << w); ++s)
+			regs[s] = -1;
+		for (int i = 0; i < w; ++i)
+			regs[1 << i] = g + i;
+
+		for (int r = 0; r < m_rows; ++r)
+		{
+			int p(0);
+			for (int i = 0; i < w; ++i)
+				p |= (int)get_bit(r, g + i) << i;
+
+			patterns[r] = p;
+		}
+
+		for (int r = 0; r < m_rows; ++r)
+		{
+			int p = patterns[r];
+			if (!p)
+				continue;
+
+			// Subsets are built from smaller ones by adding their highest bit
+			if (regs[p] < 0)
+			{
+				int chain[max_group];
+				int len(0);
+
+				for (int s = p; regs[s] < 0; )
+				{
+					chain[len++] = s;
+
+					int high(1);
+					while (high <= s >> 1)
+						high <<= 1;
+					s ^= high;
+				}
+
+				while (len--)
+				{
+					int s = chain[len];
+					int high(1);
+					while (high <= s >> 1)
+						high <<= 1;
+
+					regs[s] = tmp_base + s;
+					add_op(ops, regs[s], regs[s ^ high], regs[high]);
+					++xors;
+				}
+			}
+
+			if (started[r])
+			{
+				add_op(ops, m_cols + r, m_cols + r, regs[p]);
+				++xors;
+			}
+			else
+			{
+				add_op(ops, m_cols + r, regs[p], zero);
+				started[r] = true;
+			}
+		}
+	}
+
+	for (int r = 0; r < m_rows; ++r)
+	{
+		if (!started[r])
+			add_op(ops, m_cols + r, zero, zero);
+	}
+
+	return xors;
+}
+
+void CXorProgram::synthesize()
+{
+	std::vector<SXorOp> ops;
+
+	m_xor_count = -1;
+
+	for (int k = min_group; k <= max_group; ++k)
+	{
+		int xors = build(k, ops);
+		if (m_xor_count < 0 || xors < m_xor_count)
+		{
+			m_xor_count = xors;
+			m_group = k;
+			m_ops.swap(ops);
+		}
+	}
+}
+
+}
@@ -0,0 +1,113 @@
+//***************************************************************************************
+// xorprog.h
+// Straight-line XOR programs for multiplication by binary matrices
+//
+// Copyright  2022 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <schelkunov@re-crypt.com>
+//
+// This file is a part of wb_poc
+//
+// wb_poc is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_poc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_poc. If not, see <http://www.gnu.org/licenses/>.
+//***************************************************************************************
+
+#include "bmatrix.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#ifndef XORPROG_H
+#define XORPROG_H
+
+namespace NCrypt
+{
+
+//
+// Program computing y = m * x with XORs of words (bit-sliced planes).
+// Columns are split into groups of k, XORs of input subsets used by rows are computed once
+// per group ("Four Russians"), rows accumulate one subset per group.
+// k from 4 to 8 giving the fewest XORs is selected.
+// Every operation is r[dst] = r[a] ^ r[b], copies and zeroing use the zero register,
+// so the interpreter has no branches
+//
+class CXorProgram
+{
+public:
+	struct SXorOp
+	{
+		uint16_t	dst;
+		uint16_t	a;
+		uint16_t	b;
+	};
+
+	enum
+	{
+		min_group = 4,
+		max_group = 8
+	};
+
+public:
+	// The first rows rows of the matrix are used
+	template <int N, int M>
+	CXorProgram(const NBMatrix::TBMatrix<N, M>& m, int rows = N) : m_rows(rows), m_cols(M), m_qwords((M + 63) / 64)
+	{
+		m_bits.resize(m_rows * m_qwords);
+		for (int i = 0; i < m_rows; ++i)
+		{
+			for (int j = 0; j < m_qwords; ++j)
+				m_bits[i * m_qwords + j] = m[i].get_internal_array()[j];
+		}
+
+		synthesize();
+	}
+
+public:
+	// Registers: inputs are [0, cols), outputs are [cols, cols + rows), then the zero register and temporaries
+	int get_regs_num() const;
+	int get_in_base() const;
+	int get_out_base() const;
+	int get_zero_reg() const;
+	// Copies are not counted
+	int get_xor_count() const;
+	int get_group_size() const;
+	const std::vector<SXorOp>& get_ops() const;
+
+	// regs is [get_regs_num()][W::lanes], W provides set and xor_of over planes
+	template <typename W>
+	void run(uint64_t* regs) const
+	{
+		W::set(regs + get_zero_reg() * W::lanes, 0);
+
+		const SXorOp* op = m_ops.empty() ? 0 : &m_ops[0];
+		for (size_t i = 0; i < m_ops.size(); ++i, ++op)
+			W::xor_of(regs + op->dst * W::lanes, regs + op->a * W::lanes, regs + op->b * W::lanes);
+	}
+
+private:
+	bool get_bit(int, int) const;
+	int build(int, std::vector<SXorOp>&) const;
+	void synthesize();
+
+private:
+	int						m_rows;
+	int						m_cols;
+	int						m_qwords;
+	std::vector<uint64_t>	m_bits;
+	std::vector<SXorOp>		m_ops;
+	int						m_group;
+	int						m_xor_count;
+};
+
+}
+
+#endif // XORPROG_H